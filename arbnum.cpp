@@ -8,610 +8,3822 @@
 
 #include <limits.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
 #include "arbnum.h"
+#include "arbnum_expr.h"
+#include "arbnum_fixed.h"
 
 //------------------------------------------------------------------------------
-// Unsigned
+// Limb allocators
+
+// Freed buffers up to LARGEST bytes wait on the thread that freed them, in free lists of
+// power of two sizes, so a thread working on numbers of the same sizes again doesn't call
+// malloc().  Each thread has its own lists, so nothing is locked, and keeps at most LIMIT
+// bytes.  Plain data so every thread starts with empty lists without any setup.
+struct LimbCache {
+	static const int CLASSES = 15;
+	static const size_t SMALLEST = 64;
+	static const size_t LARGEST = SMALLEST << (CLASSES - 1);	// 1 MB
+	static const size_t LIMIT = (size_t)1 << 24;
+
+	void *free[CLASSES];	// Each free buffer starts with a pointer to the next
+	size_t cached;		// Bytes in the lists
+	size_t misses;		// Buffers that had to come from malloc() or realloc()
+	bool armed;		// The closer will empty the lists when the thread ends
+	bool closed;		// The thread is ending, buffers go straight back to free()
+};
+
+static thread_local LimbCache gLimbCache;
+
+// Smallest class with SMALLEST << class bytes at least bytes
+static int limbCacheClass(const size_t bytes) {
+	int c = 0;
+	while ((LimbCache::SMALLEST << c) < bytes) {
+		c++;
+	}
+	return c;
+}
 
-static Unsigned gUnsignedZero(0);
-static Unsigned gUnsignedOne(1);
-static Unsigned gUnsignedTwo(2);
-static const int UNASSIGNED = -1;
+static void emptyLimbCache(LimbCache &cache) {
+	for (int c = 0; c < LimbCache::CLASSES; c++) {
+		while (cache.free[c] != NULL) {
+			void *next = *(void **)cache.free[c];
+			free(cache.free[c]);
+			cache.free[c] = next;
+		}
+	}
+	cache.cached = 0;
+}
+
+class LimbCacheCloser {
+public:
+	void arm() { gLimbCache.armed = true; }
+	~LimbCacheCloser() {
+		emptyLimbCache(gLimbCache);
+		gLimbCache.closed = true;
+	}
+};
+
+static thread_local LimbCacheCloser gLimbCacheCloser;
+
+class StandardLimbAllocator : public LimbAllocator {
+public:
+	void *allocate(const size_t bytes) {
+		LimbCache &cache = gLimbCache;
+		if (bytes <= LimbCache::LARGEST) {
+			const int c = limbCacheClass(bytes);
+			void *p = cache.free[c];
+			if (p != NULL) {
+				cache.free[c] = *(void **)p;
+				cache.cached -= LimbCache::SMALLEST << c;
+				return p;
+			}
+			cache.misses++;
+			return malloc(LimbCache::SMALLEST << c);
+		}
+		cache.misses++;
+		return malloc(bytes);
+	}
+
+	void *reallocate(void *p, const size_t oldBytes, const size_t bytes) {
+		if (oldBytes > LimbCache::LARGEST && bytes > LimbCache::LARGEST) {
+			gLimbCache.misses++;
+			return realloc(p, bytes);
+		}
+		if (oldBytes <= LimbCache::LARGEST && bytes <= LimbCache::LARGEST
+				&& limbCacheClass(oldBytes) == limbCacheClass(bytes)) {
+			return p;
+		}
+
+		void *moved = allocate(bytes);
+		if (moved != NULL) {
+			memcpy(moved, p, oldBytes < bytes ? oldBytes : bytes);
+		}
+		release(p, oldBytes);
+		return moved;
+	}
+
+	void release(void *p, const size_t bytes) {
+		LimbCache &cache = gLimbCache;
+		if (bytes > LimbCache::LARGEST || cache.closed) {
+			free(p);
+			return;
+		}
+		const int c = limbCacheClass(bytes);
+		const size_t classBytes = LimbCache::SMALLEST << c;
+		if (cache.cached + classBytes > LimbCache::LIMIT) {
+			free(p);
+			return;
+		}
+		if (!cache.armed) {
+			gLimbCacheCloser.arm();
+		}
+		*(void **)p = cache.free[c];
+		cache.free[c] = p;
+		cache.cached += classBytes;
+	}
+};
+
+static thread_local LimbAllocator *gCurrentAllocator = NULL;	// NULL for standard()
+
+LimbAllocator &LimbAllocator::standard() {
+	static StandardLimbAllocator allocator;
+	return allocator;
+}
+
+LimbAllocator &LimbAllocator::current() {
+	return gCurrentAllocator != NULL ? *gCurrentAllocator : standard();
+}
+
+LimbAllocatorScope::LimbAllocatorScope(LimbAllocator &allocator) : mPrevious(gCurrentAllocator) {
+	gCurrentAllocator = &allocator;
+}
+
+LimbAllocatorScope::~LimbAllocatorScope() {
+	gCurrentAllocator = mPrevious;
+}
+
+LimbArena::LimbArena(const size_t largest, const size_t limit) :
+	mLargest(largest < BLOCK_BYTES ? largest : BLOCK_BYTES), mMaxBlocks(limit / BLOCK_BYTES),
+	mOwner(std::this_thread::get_id()), mInUse(0), mNext(NULL), mEnd(NULL) {
+}
+
+LimbArena::~LimbArena() {
+	for (size_t i = 0; i < mBlocks.size(); i++) {
+		free(mBlocks[i]);
+	}
+}
+
+void LimbArena::nextBlock() {
+	if (mInUse == mBlocks.size()) {
+		char *block = (char *)malloc(BLOCK_BYTES);
+		if (block == NULL) {
+			fprintf(stderr, "LimbArena: Out of memory\n");
+			abort();
+		}
+		mBlocks.push_back(block);
+	}
+	mNext = mBlocks[mInUse++];
+	mEnd = mNext + BLOCK_BYTES;
+}
+
+LimbAllocator &LimbArena::allocatorFor(const size_t bytes) {
+	if (bytes > mLargest) return standard();
+	if (rounded(bytes) > (size_t)(mEnd - mNext) && mInUse >= mMaxBlocks) return standard();
+	return *this;
+}
+
+void *LimbArena::allocate(const size_t bytes) {
+	if (rounded(bytes) > (size_t)(mEnd - mNext)) {
+		nextBlock();
+	}
+	void *p = mNext;
+	mNext += rounded(bytes);
+	return p;
+}
+
+// The last buffer handed out grows where it is if the block has room
+void *LimbArena::reallocate(void *p, const size_t oldBytes, const size_t bytes) {
+	if ((char *)p + rounded(oldBytes) == mNext && rounded(bytes) - rounded(oldBytes) <= (size_t)(mEnd - mNext)) {
+		mNext = (char *)p + rounded(bytes);
+		return p;
+	}
+
+	void *moved = allocate(bytes);
+	memcpy(moved, p, oldBytes);
+	return moved;
+}
+
+// Only the last buffer handed out can be given back before reset(), which suits temporaries
+void LimbArena::release(void *p, const size_t bytes) {
+	if ((char *)p + rounded(bytes) == mNext && std::this_thread::get_id() == mOwner) {
+		mNext = (char *)p;
+	}
+}
+
+void LimbArena::reset() {
+	mInUse = 0;
+	mNext = NULL;
+	mEnd = NULL;
+}
+
+LimbPool::LimbPool() {
+	for (int i = 0; i < CLASSES; i++) {
+		mFree[i] = NULL;
+	}
+}
 
-void Unsigned::pad(const size_t len) {
-	while (mDigits.size() < len) {
-		prepend(0);
+LimbPool::~LimbPool() {
+	for (int i = 0; i < CLASSES; i++) {
+		while (mFree[i] != NULL) {
+			void *next = *(void **)mFree[i];
+			free(mFree[i]);
+			mFree[i] = next;
+		}
+	}
+}
+
+// Smallest class with SMALLEST << class bytes at least bytes
+int LimbPool::sizeClass(const size_t bytes) {
+	int c = 0;
+	while ((SMALLEST << c) < bytes) {
+		c++;
+	}
+	return c;
+}
+
+LimbAllocator &LimbPool::allocatorFor(const size_t bytes) {
+	return bytes > (SMALLEST << (CLASSES - 1)) ? standard() : *this;
+}
+
+void *LimbPool::allocate(const size_t bytes) {
+	const int c = sizeClass(bytes);
+	{
+		std::lock_guard<std::mutex> guard(mLock);
+		if (mFree[c] != NULL) {
+			void *p = mFree[c];
+			mFree[c] = *(void **)p;
+			return p;
+		}
 	}
+	return malloc(SMALLEST << c);
 }
 
-void Unsigned::appendRight(const int digit, const size_t numberOfDigits) {
-	for (size_t i = 0; i < numberOfDigits; i++) {
-		append(digit);
+void *LimbPool::reallocate(void *p, const size_t oldBytes, const size_t bytes) {
+	if (sizeClass(bytes) == sizeClass(oldBytes)) return p;
+
+	void *moved = allocate(bytes);
+	if (moved != NULL) {
+		memcpy(moved, p, oldBytes < bytes ? oldBytes : bytes);
 	}
+	release(p, oldBytes);
+	return moved;
+}
+
+void LimbPool::release(void *p, const size_t bytes) {
+	const int c = sizeClass(bytes);
+	std::lock_guard<std::mutex> guard(mLock);
+	*(void **)p = mFree[c];
+	mFree[c] = p;
+}
+
+//------------------------------------------------------------------------------
+// Unsigned::Limbs
+
+Unsigned::Limbs::Limbs(const Limbs &in) : mData(mInline), mSize(0), mCapacity(INLINE_LIMBS), mAllocator(NULL) {
+	*this = in;
+}
+
+Unsigned::Limbs::Limbs(Limbs &&in) noexcept : mData(mInline), mSize(0), mCapacity(INLINE_LIMBS), mAllocator(NULL) {
+	*this = std::move(in);
+}
+
+Unsigned::Limbs &Unsigned::Limbs::operator=(const Limbs &in) {
+	if (this == &in) return *this;
+
+	reserve(in.mSize);
+	memcpy(mData, in.mData, in.mSize * sizeof(limb_t));
+	mSize = in.mSize;
+	return *this;
 }
 
-void Unsigned::padShorterNumber(Unsigned &a, Unsigned &b) {
-	if (a.length() < b.length()) {
-		a.pad(b.length());
+// Takes over a heap buffer, leaving in empty.  Inline limbs still have to be copied.
+Unsigned::Limbs &Unsigned::Limbs::operator=(Limbs &&in) noexcept {
+	if (this == &in) return *this;
+
+	if (in.isInline()) {
+		memcpy(mData, in.mData, in.mSize * sizeof(limb_t));
+		mSize = in.mSize;
 	}
 	else {
-		b.pad(a.length());
+		if (!isInline()) mAllocator->release(mData, mCapacity * sizeof(limb_t));
+		mData = in.mData;
+		mSize = in.mSize;
+		mCapacity = in.mCapacity;
+		mAllocator = in.mAllocator;
+		in.mData = in.mInline;
+		in.mCapacity = INLINE_LIMBS;
+		in.mAllocator = NULL;
 	}
+	in.mSize = 0;
+	return *this;
 }
 
-void Unsigned::padShorterNumber(const Unsigned *&pA, const Unsigned *&pB, Unsigned &padded) {
-	if (pA->length() < pB->length()) {
-		padded = *pA;
-		padded.pad(pB->length());
-		pA = &padded;
+// Spill to the heap, or grow the heap buffer, doubling so push_back() is amortized O(1).
+// A buffer from another allocator than this thread's is moved over rather than grown.
+void Unsigned::Limbs::grow(const size_t wanted) {
+	size_t newCapacity = mCapacity * 2;
+	if (newCapacity < wanted) {
+		newCapacity = wanted;
+	}
+
+	const size_t bytes = newCapacity * sizeof(limb_t);
+	LimbAllocator &allocator = LimbAllocator::current().allocatorFor(bytes);
+	if (!isInline() && &allocator == mAllocator) {
+		mData = (limb_t *)allocator.reallocate(mData, mCapacity * sizeof(limb_t), bytes);
 	}
 	else {
-		padded = *pB;
-		padded.pad(pA->length());
-		pB = &padded;
+		limb_t *heap = (limb_t *)allocator.allocate(bytes);
+		if (heap != NULL) {
+			memcpy(heap, mData, mSize * sizeof(limb_t));
+		}
+		if (!isInline()) {
+			mAllocator->release(mData, mCapacity * sizeof(limb_t));
+		}
+		mData = heap;
+		mAllocator = &allocator;
+	}
+
+	if (mData == NULL) {
+		fprintf(stderr, "Unsigned: Out of memory\n");
+		abort();
 	}
+	mCapacity = newCapacity;
 }
 
-void Unsigned::zero() {
-#if __cplusplus >= 201103L // Check if C++11 or later
-    for (auto &digit : mDigits) {
-        digit = 0;
-    }
-#else
-    for (digits_t::iterator it = mDigits.begin(); it != mDigits.end(); it++) {
-        *it = 0;
-    }
-#endif
+void Unsigned::Limbs::resize(const size_t n, const limb_t fill) {
+	reserve(n);
+	for (size_t i = mSize; i < n; i++) {
+		mData[i] = fill;
+	}
+	mSize = n;
 }
 
-bool Unsigned::isZero() const {
-	if (length() == 0) return true;
+void Unsigned::Limbs::assign(const size_t n, const limb_t fill) {
+	clear();
+	resize(n, fill);
+}
+
+// Insert count zero limbs at the least significant end
+void Unsigned::Limbs::insertLow(const size_t count) {
+	reserve(mSize + count);
+	memmove(mData + count, mData, mSize * sizeof(limb_t));
+	memset(mData, 0, count * sizeof(limb_t));
+	mSize += count;
+}
+
+// Remove count limbs from the least significant end
+void Unsigned::Limbs::eraseLow(const size_t count) {
+	memmove(mData, mData + count, (mSize - count) * sizeof(limb_t));
+	mSize -= count;
+}
 
-	for (digits_t::const_iterator it = mDigits.begin(); it != mDigits.end(); it++) {
-		if (*it != 0) return false;
+//------------------------------------------------------------------------------
+// Limb kernels
+//
+// These work on raw arrays of limbs, least significant first.  The Unsigned
+// algorithms below are built on top of them.
+//
+// addN(), subN() and the single limb multiplies come in sets, and the best set
+// this CPU can run is picked at startup.  Unsigned::setKernels() picks another.
+//	portable	A limb at a time, anywhere
+//	x86-64		Two limbs at a time as one 64 bit word.  The carries go through
+//			the carry flag with _addcarry_u64() and _subborrow_u64(), and a
+//			word times a limb is one 64 bit multiply.
+//	bmi2		addMul1() and subMul1() in assembly with mulx and two carry
+//			chains, adox and adcx.  The rest as x86-64 built for BMI2.
+// Carry chains are serial and the limbs are 32 bits, so AVX2 and AVX-512 IFMA
+// have nothing to offer these.
+
+typedef Unsigned::limb_t limb_t;
+typedef Unsigned::dlimb_t dlimb_t;
+static const int LIMB_BITS = Unsigned::LIMB_BITS;
+
+// r = a + b, all n limbs long.  Returns the carry.
+static limb_t addNPortable(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	dlimb_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t sum = (dlimb_t)a[i] + b[i] + carry;
+		r[i] = (limb_t)sum;
+		carry = sum >> LIMB_BITS;
 	}
+	return (limb_t)carry;
+}
 
-	return true;
+// r = a - b, all n limbs long.  Returns the borrow.
+static limb_t subNPortable(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	limb_t borrow = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t diff = (dlimb_t)a[i] - b[i] - borrow;
+		r[i] = (limb_t)diff;
+		borrow = (limb_t)(diff >> LIMB_BITS) & 1;
+	}
+	return borrow;
 }
 
-bool Unsigned::isOne() const {
-	if (length() != 1) return false;
-	return mDigits[0] == 1;
+// r = a * m, n limbs long.  Returns the high limb.
+static limb_t mul1Portable(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	dlimb_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t t = (dlimb_t)a[i] * m + carry;
+		r[i] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+	return (limb_t)carry;
 }
 
-bool Unsigned::isTwo() const {
-	if (length() != 1) return false;
-	return mDigits[0] == 2;
+// r += a * m, n limbs long.  Returns the high limb.
+static limb_t addMul1Portable(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	dlimb_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t t = (dlimb_t)a[i] * m + r[i] + carry;
+		r[i] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+	return (limb_t)carry;
 }
 
-inline bool isOdd(const int n) { return n % 2 != 0; }
+// r -= a * m, n limbs long.  Returns the limb to borrow from above.
+static limb_t subMul1Portable(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	dlimb_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t t = (dlimb_t)a[i] * m + carry;
+		const limb_t low = (limb_t)t;
+		carry = (t >> LIMB_BITS) + (r[i] < low ? 1 : 0);
+		r[i] -= low;
+	}
+	return (limb_t)carry;
+}
 
-inline bool isEven(const int n) { return ! isOdd(n); }
+#if defined(__GNUC__) && defined(__x86_64__)
 
-bool Unsigned::isOdd() const {
-	if (length() == 0) return false;
-	const int lastDigit = mDigits[length() - 1];
-	return ::isOdd(lastDigit);
+// The word at a time bodies are inlined into an x86-64 and a bmi2 copy of each kernel
+
+static inline unsigned long long loadWord(const limb_t *p) {
+	unsigned long long word;
+	memcpy(&word, p, sizeof(word));
+	return word;
 }
 
-bool Unsigned::isEven() const {
-	if (length() == 0) return true;
-	const int lastDigit = mDigits[length() - 1];
-	return ::isEven(lastDigit);
+static inline void storeWord(limb_t *p, const unsigned long long word) {
+	memcpy(p, &word, sizeof(word));
 }
 
-void Unsigned::trim() {
-	digits_t::iterator lastZero;
-	bool hits = false;
+__attribute__((always_inline)) static inline limb_t addNWords(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	unsigned char carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		unsigned long long sum;
+		carry = _addcarry_u64(carry, loadWord(a + i), loadWord(b + i), &sum);
+		storeWord(r + i, sum);
+	}
+	if (i < n) {
+		const dlimb_t sum = (dlimb_t)a[i] + b[i] + carry;
+		r[i] = (limb_t)sum;
+		return (limb_t)(sum >> LIMB_BITS);
+	}
+	return carry;
+}
 
-	for (digits_t::iterator it = mDigits.begin(); it != mDigits.end(); it++) {
-		if (*it != 0) break;
-		lastZero = it;
-		hits = true;
+__attribute__((always_inline)) static inline limb_t subNWords(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	unsigned char borrow = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		unsigned long long diff;
+		borrow = _subborrow_u64(borrow, loadWord(a + i), loadWord(b + i), &diff);
+		storeWord(r + i, diff);
 	}
+	if (i < n) {
+		const dlimb_t diff = (dlimb_t)a[i] - b[i] - borrow;
+		r[i] = (limb_t)diff;
+		return (limb_t)(diff >> LIMB_BITS) & 1;
+	}
+	return borrow;
+}
 
-	if (!hits) return;
+__attribute__((always_inline)) static inline limb_t mul1Words(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	unsigned long long carry = 0;	// Always below 2^32
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		const unsigned __int128 t = (unsigned __int128)loadWord(a + i) * m + carry;
+		storeWord(r + i, (unsigned long long)t);
+		carry = (unsigned long long)(t >> 64);
+	}
+	if (i < n) {
+		const dlimb_t t = (dlimb_t)a[i] * m + carry;
+		r[i] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+	return (limb_t)carry;
+}
 
-	if (lastZero != mDigits.end()) {
-		lastZero++;	// Because erase() doesn't include the last index
+__attribute__((always_inline)) static inline limb_t addMul1Words(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	unsigned long long carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		const unsigned __int128 t = (unsigned __int128)loadWord(a + i) * m + loadWord(r + i) + carry;
+		storeWord(r + i, (unsigned long long)t);
+		carry = (unsigned long long)(t >> 64);
+	}
+	if (i < n) {
+		const dlimb_t t = (dlimb_t)a[i] * m + r[i] + carry;
+		r[i] = (limb_t)t;
+		carry = t >> LIMB_BITS;
 	}
+	return (limb_t)carry;
+}
 
-	if (lastZero == mDigits.end()) {
-		lastZero--;	// Its all zeros, keep one
+__attribute__((always_inline)) static inline limb_t subMul1Words(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	unsigned long long carry = 0;
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		const unsigned __int128 t = (unsigned __int128)loadWord(a + i) * m + carry;
+		const unsigned long long low = (unsigned long long)t;
+		const unsigned long long word = loadWord(r + i);
+		carry = (unsigned long long)(t >> 64) + (word < low ? 1 : 0);
+		storeWord(r + i, word - low);
+	}
+	if (i < n) {
+		const dlimb_t t = (dlimb_t)a[i] * m + carry;
+		const limb_t low = (limb_t)t;
+		carry = (t >> LIMB_BITS) + (r[i] < low ? 1 : 0);
+		r[i] -= low;
 	}
+	return (limb_t)carry;
+}
 
-	mDigits.erase(mDigits.begin(), lastZero);
+static limb_t addNX86(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return addNWords(r, a, b, n);
+}
+static limb_t subNX86(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return subNWords(r, a, b, n);
+}
+static limb_t mul1X86(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return mul1Words(r, a, n, m);
+}
+static limb_t addMul1X86(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return addMul1Words(r, a, n, m);
+}
+static limb_t subMul1X86(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return subMul1Words(r, a, n, m);
 }
 
-int Unsigned::charToInt(const char c) {
-	return c - '0';
+__attribute__((target("bmi2,adx"))) static limb_t addNBmi2(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return addNWords(r, a, b, n);
+}
+__attribute__((target("bmi2,adx"))) static limb_t subNBmi2(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return subNWords(r, a, b, n);
+}
+__attribute__((target("bmi2,adx"))) static limb_t mul1Bmi2(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return mul1Words(r, a, n, m);
 }
 
-char Unsigned::intToChar(const int n) {
-	if (n < 0) return '^';
-	return (char)(n + '0');
+// r += a * m a word at a time with two carry chains: adox adds the previous word's high half
+// of the product into this word's low half while adcx adds that into r.  lea and jrcxz step
+// the negative word index in rcx, as they leave both flags alone.
+__attribute__((target("bmi2,adx"))) static limb_t addMul1Bmi2(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	const size_t words = n / 2;
+	unsigned long long carry = 0;
+	if (words > 0) {
+		long long i = -(long long)words;	// 64 bits even where long isn't, it indexes in rcx
+		unsigned long long zero, low, high, word;
+		__asm__ volatile(
+			"xor %[zero], %[zero]\n\t"
+			"xor %[carry], %[carry]\n"
+			"1:\n\t"
+			"mulx (%[a],%[i],8), %[low], %[high]\n\t"
+			"adox %[carry], %[low]\n\t"
+			"mov (%[r],%[i],8), %[word]\n\t"
+			"adcx %[low], %[word]\n\t"
+			"mov %[word], (%[r],%[i],8)\n\t"
+			"mov %[high], %[carry]\n\t"
+			"lea 1(%[i]), %[i]\n\t"
+			"jrcxz 2f\n\t"
+			"jmp 1b\n"
+			"2:\n\t"
+			"adox %[zero], %[carry]\n\t"
+			"adcx %[zero], %[carry]"
+			: [i] "+c" (i), [carry] "=&r" (carry), [zero] "=&r" (zero), [low] "=&r" (low), [high] "=&r" (high), [word] "=&r" (word)
+			: [a] "r" (a + 2 * words), [r] "r" (r + 2 * words), "d" ((unsigned long long)m)
+			: "cc", "memory");
+	}
+	if (n % 2 != 0) {
+		const dlimb_t t = (dlimb_t)a[n - 1] * m + r[n - 1] + carry;
+		r[n - 1] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+	return (limb_t)carry;
 }
 
-void Unsigned::clear() {
-	mDigits.clear();
+// r -= a * m the same way.  r - t is r + ~t + 1, so adcx adds the complement starting with the
+// carry flag set, and a clear carry flag means a borrow.
+__attribute__((target("bmi2,adx"))) static limb_t subMul1Bmi2(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	const size_t words = n / 2;
+	unsigned long long carry = 0;
+	if (words > 0) {
+		long long i = -(long long)words;
+		unsigned long long zero, low, high, word;
+		__asm__ volatile(
+			"xor %[zero], %[zero]\n\t"
+			"xor %[carry], %[carry]\n\t"
+			"stc\n"
+			"1:\n\t"
+			"mulx (%[a],%[i],8), %[low], %[high]\n\t"
+			"adox %[carry], %[low]\n\t"
+			"not %[low]\n\t"
+			"mov (%[r],%[i],8), %[word]\n\t"
+			"adcx %[low], %[word]\n\t"
+			"mov %[word], (%[r],%[i],8)\n\t"
+			"mov %[high], %[carry]\n\t"
+			"lea 1(%[i]), %[i]\n\t"
+			"jrcxz 2f\n\t"
+			"jmp 1b\n"
+			"2:\n\t"
+			"adox %[zero], %[carry]\n\t"
+			"cmc\n\t"
+			"adcx %[zero], %[carry]"
+			: [i] "+c" (i), [carry] "=&r" (carry), [zero] "=&r" (zero), [low] "=&r" (low), [high] "=&r" (high), [word] "=&r" (word)
+			: [a] "r" (a + 2 * words), [r] "r" (r + 2 * words), "d" ((unsigned long long)m)
+			: "cc", "memory");
+	}
+	if (n % 2 != 0) {
+		const dlimb_t t = (dlimb_t)a[n - 1] * m + carry;
+		const limb_t low = (limb_t)t;
+		carry = (t >> LIMB_BITS) + (r[n - 1] < low ? 1 : 0);
+		r[n - 1] -= low;
+	}
+	return (limb_t)carry;
 }
 
-void Unsigned::mkError() {
-	clear();	// Doesn't really set an error.  But will case unit tests to fail which should raise a flag.
+// CPUID leaf 7 has BMI2 in bit 8 of ebx and ADX in bit 19
+static bool hasBmi2() {
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+	return (ebx & (1u << 8)) != 0 && (ebx & (1u << 19)) != 0;
 }
 
-void Unsigned::saveNumber(const char *s) {
-	for (const char *p = s; *p; p++) {
-		if (*p == '.') {
-			fprintf(stderr, "Decimals are not supported -- only integers: %s\n", s);
-			mkError();
-			return;
-		}
+#endif
 
-		if (!isdigit(*p)) {
-			fprintf(stderr, "Invalid number: %s\n", s);
-			mkError();
-			return;
-		}
+static bool runsAnywhere() {
+	return true;
+}
+
+struct LimbKernels {
+	const char *name;
+	bool (*supported)();
+	limb_t (*addN)(limb_t *, const limb_t *, const limb_t *, const size_t);
+	limb_t (*subN)(limb_t *, const limb_t *, const limb_t *, const size_t);
+	limb_t (*mul1)(limb_t *, const limb_t *, const size_t, const limb_t);
+	limb_t (*addMul1)(limb_t *, const limb_t *, const size_t, const limb_t);
+	limb_t (*subMul1)(limb_t *, const limb_t *, const size_t, const limb_t);
+};
+
+// Slowest first
+static const LimbKernels gLimbKernels[] = {
+	{ "portable", runsAnywhere, addNPortable, subNPortable, mul1Portable, addMul1Portable, subMul1Portable },
+#if defined(__GNUC__) && defined(__x86_64__)
+	{ "x86-64", runsAnywhere, addNX86, subNX86, mul1X86, addMul1X86, subMul1X86 },
+	{ "bmi2", hasBmi2, addNBmi2, subNBmi2, mul1Bmi2, addMul1Bmi2, subMul1Bmi2 },
+#endif
+};
+static const int nLimbKernels = sizeof(gLimbKernels) / sizeof(gLimbKernels[0]);
 
-		append(charToInt(*p));
+// Portable until startup reaches gKernelPicker, so numbers made by other files' statics still work.
+// Atomic so setKernels() can run while other threads work, each call then uses one set or the
+// other.  Every set gives the same results, so relaxed is enough.
+static std::atomic<const LimbKernels *> gKernels(&gLimbKernels[0]);
+
+static const LimbKernels *bestKernels() {
+	for (int i = nLimbKernels - 1; i > 0; i--) {
+		if (gLimbKernels[i].supported()) return &gLimbKernels[i];
 	}
-	trim();
+	return &gLimbKernels[0];
 }
 
-std::string Unsigned::toString() const {
-	std::string out = "";
+static struct KernelPicker {
+	KernelPicker() { gKernels.store(bestKernels(), std::memory_order_relaxed); }
+} gKernelPicker;
 
-	for (digits_t::const_iterator it = mDigits.begin(); it != mDigits.end(); it++) {
-		out += intToChar(*it);
+// NULL picks the best this CPU can run
+bool Unsigned::setKernels(const char *name) {
+	if (name == NULL) {
+		gKernels.store(bestKernels(), std::memory_order_relaxed);
+		return true;
 	}
+	for (int i = 0; i < nLimbKernels; i++) {
+		if (strcmp(gLimbKernels[i].name, name) == 0) {
+			if (!gLimbKernels[i].supported()) return false;
+			gKernels.store(&gLimbKernels[i], std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
 
-	return out;
+const char *Unsigned::getKernels() {
+	return gKernels.load(std::memory_order_relaxed)->name;
 }
 
-int Unsigned::toInt() const {
-	return atoi(toString().c_str());
+// The kernel sets this CPU can run, slowest first
+std::vector<const char *> Unsigned::kernelChoices() {
+	std::vector<const char *> names;
+	for (int i = 0; i < nLimbKernels; i++) {
+		if (gLimbKernels[i].supported()) {
+			names.push_back(gLimbKernels[i].name);
+		}
+	}
+	return names;
 }
 
-long Unsigned::toLong() const {
-	return atol(toString().c_str());
+static inline limb_t addN(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return gKernels.load(std::memory_order_relaxed)->addN(r, a, b, n);
 }
 
-long long Unsigned::toLongLong() const {
-#if defined(_MSC_VER) && _MSC_VER <= 1400
-#pragma message("Sorry " __FUNCTION__ " isn't supported on this compiler")
-	return atol(toString().c_str());
-#else
-	return atoll(toString().c_str());
-#endif
+static inline limb_t subN(limb_t *r, const limb_t *a, const limb_t *b, const size_t n) {
+	return gKernels.load(std::memory_order_relaxed)->subN(r, a, b, n);
 }
 
-void Unsigned::set(const Unsigned &in) {
-	mDigits = in.mDigits;
+static inline limb_t mul1(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return gKernels.load(std::memory_order_relaxed)->mul1(r, a, n, m);
 }
 
-Unsigned::Unsigned(const Unsigned &in) {
-	set(in);
+static inline limb_t addMul1(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return gKernels.load(std::memory_order_relaxed)->addMul1(r, a, n, m);
 }
 
-Unsigned::Unsigned(const char *in) {
-	saveNumber(in);
+static inline limb_t subMul1(limb_t *r, const limb_t *a, const size_t n, const limb_t m) {
+	return gKernels.load(std::memory_order_relaxed)->subMul1(r, a, n, m);
 }
 
-Unsigned::Unsigned(const int n) {
-	char	buf[100];
+// r = a + carry, n limbs long.  Returns the carry out.
+static limb_t add1(limb_t *r, const limb_t *a, const size_t n, limb_t carry) {
+	size_t i = 0;
+	for (; carry != 0 && i < n; i++) {
+		const limb_t sum = a[i] + carry;
+		carry = sum < carry ? 1 : 0;
+		r[i] = sum;
+	}
+	if (r != a) {
+		for (; i < n; i++) {
+			r[i] = a[i];
+		}
+	}
+	return carry;
+}
 
-#ifdef __BORLANDC__
-	sprintf(buf, "%d", n);
-#else
-	snprintf(buf, sizeof(buf), "%d", n);
-#endif
+// r = a - borrow, n limbs long.  Returns the borrow out.
+static limb_t sub1(limb_t *r, const limb_t *a, const size_t n, limb_t borrow) {
+	size_t i = 0;
+	for (; borrow != 0 && i < n; i++) {
+		const limb_t diff = a[i] - borrow;
+		borrow = a[i] < borrow ? 1 : 0;
+		r[i] = diff;
+	}
+	if (r != a) {
+		for (; i < n; i++) {
+			r[i] = a[i];
+		}
+	}
+	return borrow;
+}
 
-	saveNumber(buf);
+// r = a + b where an >= bn.  r is an limbs long.  Returns the carry.
+static limb_t addLimbs(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	const limb_t carry = addN(r, a, b, bn);
+	return add1(r + bn, a + bn, an - bn, carry);
 }
 
-Unsigned::Unsigned(const long n) {
-	char	buf[100];
+// r = a - b where an >= bn.  r is an limbs long.  Returns the borrow.
+static limb_t subLimbs(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	const limb_t borrow = subN(r, a, b, bn);
+	return sub1(r + bn, a + bn, an - bn, borrow);
+}
 
-#ifdef __BORLANDC__
-	sprintf(buf, "%ld", n);
-#else
-	snprintf(buf, sizeof(buf), "%ld", n);
-#endif
+// Length of a without its leading zero limbs
+static size_t normalizedLength(const limb_t *a, size_t n) {
+	while (n > 0 && a[n - 1] == 0) {
+		n--;
+	}
+	return n;
+}
 
-	saveNumber(buf);
+//------------------------------------------------------------------------------
+// Threads
+//
+// Big multiplications hand their independent pieces to parallelFor().  Threads
+// come out of a shared budget so nested parallel work never runs more than
+// Unsigned::getThreads() threads at once.  Every piece writes its own result and
+// the results are combined in a fixed order, so the answer never depends on the
+// number of threads.  The helper threads wait in a pool between calls, so their
+// thread_local scratch space and limb caches last from one call to the next.
+
+static std::atomic<int> gThreads(0);	// 0 until setThreads() or the first getThreads()
+static std::atomic<int> gSpareThreads(0);
+
+// Threads claimed by a running parallelFor() stay claimed, so only the change
+// goes into the budget.  It can dip below zero until they are given back.
+void Unsigned::setThreads(const int threads) {
+	const int wanted = threads < 1 ? 1 : threads;
+	const int old = gThreads.exchange(wanted);
+	gSpareThreads += wanted - (old == 0 ? 1 : old);
 }
 
-Unsigned::Unsigned(const long long n) {
-	char	buf[100];
+int Unsigned::getThreads() {
+	const int threads = gThreads;
+	if (threads != 0) return threads;
 
-#ifdef __BORLANDC__
-	sprintf(buf, "%lld", n);
-#else
-	snprintf(buf, sizeof(buf), "%lld", n);
-#endif
+	const int hardware = (int)std::thread::hardware_concurrency();
+	const int wanted = hardware > 0 ? hardware : 1;
+	int expected = 0;
+	if (gThreads.compare_exchange_strong(expected, wanted)) {
+		gSpareThreads += wanted - 1;
+		return wanted;
+	}
+	return expected;
+}
+
+// Take up to wanted threads from the budget
+static int claimThreads(const int wanted) {
+	Unsigned::getThreads();
 
-	saveNumber(buf);
+	int spare = gSpareThreads;
+	for (;;) {
+		const int take = spare < wanted ? spare : wanted;
+		if (take <= 0) return 0;
+		if (gSpareThreads.compare_exchange_weak(spare, spare - take)) return take;
+	}
 }
 
-Unsigned::Unsigned(const bool b) {
-	set((int)b);
+static void releaseThreads(const int count) {
+	gSpareThreads += count;
 }
 
-// a += b
-// Both a and b will be modified so if you don't want that send in a copy
-inline void Unsigned::addMutable(Unsigned &workingA, Unsigned &workingB) {
-	padShorterNumber(workingA, workingB);
+// Counts down the helpers of one parallelFor()
+class Latch {
+	std::mutex mLock;
+	std::condition_variable mDone;
+	int mRemaining;
+
+public:
+	explicit Latch(const int count) : mRemaining(count) { }
 
-	int carry = 0;
-	for (int i = (int)workingA.length() - 1; i >= 0; i--) {
-		int digit = workingA[i] + workingB[i] + carry;
-		if (digit > 9) {
-			carry = 1;
-			digit -= 10;
+	void countDown() {
+		std::lock_guard<std::mutex> hold(mLock);
+		if (--mRemaining == 0) {
+			mDone.notify_all();
 		}
-		else {
-			carry = 0;
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> hold(mLock);
+		while (mRemaining > 0) {
+			mDone.wait(hold);
+		}
+	}
+};
+
+// Threads that sleep until there is a job.  A new one starts only when every
+// thread is busy.  A thread is idle again before it counts its job done, so the
+// pool never holds more threads than the budget has handed out at once.
+class WorkerPool {
+public:
+	typedef void (*Run)(void *);
+
+private:
+	struct Job {
+		Run run;
+		void *context;
+		Latch *done;
+	};
+
+	std::mutex mLock;
+	std::condition_variable mWake;
+	std::deque<Job> mJobs;
+	std::vector<std::thread> mWorkers;
+	size_t mIdle;
+	bool mStopping;
+
+	void work() {
+		std::unique_lock<std::mutex> hold(mLock);
+		for (;;) {
+			while (mJobs.empty() && !mStopping) {
+				mWake.wait(hold);
+			}
+			if (mJobs.empty()) return;
+
+			const Job job = mJobs.front();
+			mJobs.pop_front();
+			mIdle--;
+			hold.unlock();
+			job.run(job.context);
+			hold.lock();
+			mIdle++;
+			hold.unlock();
+			job.done->countDown();
+			hold.lock();
 		}
-		workingA[i] = digit;
 	}
 
-	if (carry > 0) {
-		workingA.prepend(carry);
+public:
+	WorkerPool() : mIdle(0), mStopping(false) { }
+
+	size_t size() {
+		std::lock_guard<std::mutex> hold(mLock);
+		return mWorkers.size();
 	}
 
-	workingA.trim();
+	~WorkerPool() {
+		{
+			std::lock_guard<std::mutex> hold(mLock);
+			mStopping = true;
+		}
+		mWake.notify_all();
+		for (size_t i = 0; i < mWorkers.size(); i++) {
+			mWorkers[i].join();
+		}
+	}
+
+	void run(const Run run, void *context, Latch &done) {
+		std::lock_guard<std::mutex> hold(mLock);
+		const Job job = { run, context, &done };
+		mJobs.push_back(job);
+		if (mJobs.size() > mIdle) {
+			mIdle++;
+			mWorkers.push_back(std::thread(&WorkerPool::work, this));
+		}
+		mWake.notify_one();
+	}
+};
+
+static WorkerPool &workerPool() {
+	static WorkerPool pool;
+	return pool;
 }
 
-// result = a + b
-Unsigned Unsigned::add(const Unsigned &a, const Unsigned &b) {
-	Unsigned workingA(a);
-	Unsigned workingB(b);
 
-	addMutable(workingA, workingB);
+template <typename Worker>
+static void runWorker(void *worker) {
+	(*(const Worker *)worker)();
+}
 
-	return workingA;
+// task(i) for each i in [0, count), spread over spare threads if there are any
+template <typename Task>
+static void parallelFor(const size_t count, const Task &task) {
+	const int extra = count > 1 ? claimThreads((int)count - 1) : 0;
+	if (extra == 0) {
+		for (size_t i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	const auto worker = [&]() {
+		for (size_t i = next++; i < count; i = next++) {
+			task(i);
+		}
+	};
+	Latch helpersDone(extra);
+	for (int t = 0; t < extra; t++) {
+		workerPool().run(runWorker<decltype(worker)>, (void *)&worker, helpersDone);
+	}
+	worker();
+	helpersDone.wait();
+
+	releaseThreads(extra);
 }
 
-// a -= b
-//	Both a and b will be modified so if you don't want that send in a copy
-void Unsigned::subtractMutable(Unsigned &workingA, Unsigned &workingB) {
-	padShorterNumber(workingA, workingB);
+// task(begin, end) over [0, n) cut into chunks of at least minChunk
+template <typename Task>
+static void parallelRange(const size_t n, const size_t minChunk, const Task &task) {
+	size_t chunks = n / minChunk;
+	if (chunks > (size_t)Unsigned::getThreads()) {
+		chunks = Unsigned::getThreads();
+	}
+	if (chunks <= 1) {
+		task((size_t)0, n);
+		return;
+	}
 
-	int borrow = 0;
-	for (int i = (int)workingA.length() - 1; i >= 0; i--) {
-		workingA[i] = workingA[i] - borrow;
-		if (workingB[i] > workingA[i]) {
-			workingA[i] = workingA[i] + 10;
-			borrow = 1;
+	const size_t chunkLength = (n + chunks - 1) / chunks;
+	parallelFor(chunks, [&](const size_t chunk) {
+		const size_t begin = chunk * chunkLength;
+		const size_t end = begin + chunkLength < n ? begin + chunkLength : n;
+		if (begin < end) {
+			task(begin, end);
 		}
-		else {
-			borrow = 0;
+	});
+}
+
+//------------------------------------------------------------------------------
+// Scratch space
+//
+// The kernels take their temporary limbs from a workspace each thread keeps, not the heap.
+// A Scratch takes space in stack order and gives it all back when it goes out of scope.
+// The workspace keeps what it has grown to, so once a thread has done an operation of some
+// size, doing it again doesn't allocate.
+
+class Workspace {
+	struct Chunk {
+		limb_t *data;
+		size_t size;
+	};
+
+	std::vector<Chunk> mChunks;
+	size_t mChunk;	// The chunk being handed out
+	size_t mUsed;	// Limbs of it handed out
+
+	// Replaces the chunks from first on with one of at least limbs, and twice all there was
+	void grow(const size_t first, const size_t limbs) {
+		size_t size = 2 * total();
+		if (size < limbs) {
+			size = limbs;
 		}
+		for (size_t i = first; i < mChunks.size(); i++) {
+			free(mChunks[i].data);
+		}
+		mChunks.resize(first);
+
+		Chunk chunk;
+		chunk.data = (limb_t *)malloc(size * sizeof(limb_t));
+		chunk.size = size;
+		if (chunk.data == NULL) {
+			fprintf(stderr, "Workspace: Out of memory\n");
+			abort();
+		}
+		mChunks.push_back(chunk);
+	}
+
+public:
+	Workspace() : mChunk(0), mUsed(0) { }
+	~Workspace() {
+		for (size_t i = 0; i < mChunks.size(); i++) {
+			free(mChunks[i].data);
+		}
+	}
 
-		const int digit = workingA[i] - workingB[i];
-		workingA[i] = digit;
+	// Limbs in all the chunks
+	size_t total() const {
+		size_t limbs = 0;
+		for (size_t i = 0; i < mChunks.size(); i++) {
+			limbs += mChunks[i].size;
+		}
+		return limbs;
 	}
 
-	if (borrow > 0) {
-		fprintf(stderr, "Unsigned::subtract: Should not have a borrow\n");
-		workingA.mkError();
+	void mark(size_t &chunk, size_t &used) const {
+		chunk = mChunk;
+		used = mUsed;
+	}
+
+	// Back to a mark().  Once nothing is taken, more than one chunk becomes one big one.
+	void giveBack(const size_t chunk, const size_t used) {
+		mChunk = chunk;
+		mUsed = used;
+		if (mChunk == 0 && mUsed == 0 && mChunks.size() > 1) {
+			grow(0, 0);
+		}
+	}
+
+	limb_t *take(const size_t limbs) {
+		if (mChunks.empty() || mChunks[mChunk].size - mUsed < limbs) {
+			const size_t next = mChunks.empty() ? 0 : mChunk + 1;
+			if (next == mChunks.size() || mChunks[next].size < limbs) {
+				grow(next, limbs);
+			}
+			mChunk = next;
+			mUsed = 0;
+		}
+		limb_t *p = mChunks[mChunk].data + mUsed;
+		mUsed += limbs;
+		return p;
+	}
+
+	// Room for limbs in one chunk up front, while nothing is taken
+	void reserve(const size_t limbs) {
+		if (mChunk == 0 && mUsed == 0 && (mChunks.empty() || mChunks[0].size < limbs)) {
+			grow(0, limbs);
+		}
+	}
+};
+
+static Workspace &workspace() {
+	static thread_local Workspace threadWorkspace;
+	return threadWorkspace;
+}
+
+class Scratch {
+	Workspace &mWorkspace;
+	size_t mChunk;
+	size_t mUsed;
+
+public:
+	Scratch() : mWorkspace(workspace()) { mWorkspace.mark(mChunk, mUsed); }
+	~Scratch() { mWorkspace.giveBack(mChunk, mUsed); }
+
+	limb_t *take(const size_t limbs) { return mWorkspace.take(limbs); }
+};
+
+//------------------------------------------------------------------------------
+// Multiplication
+//
+// Unsigned::multiply() and Unsigned::square() pick the algorithm from the
+// operand sizes, in limbs:
+//	below KARATSUBA_THRESHOLD	schoolbook basecase
+//	below TOOM3_THRESHOLD		Karatsuba
+//	below TOOM4_THRESHOLD		Toom-3
+//	below NTT_THRESHOLD		Toom-4
+//	above				number theoretic transform, while the product fits in NTT_MAX_LIMBS
+// The schoolbook and Karatsuba tiers work on raw limb arrays in mulLimbs().
+// Products too big for the transform are split up by Toom-4 until the pieces fit.
+// From PARALLEL_THRESHOLD limbs the independent sub-products run on separate threads.
+
+static const size_t KARATSUBA_THRESHOLD = 32;
+static const size_t TOOM3_THRESHOLD = 300;
+static const size_t TOOM4_THRESHOLD = 800;
+static const size_t NTT_THRESHOLD = 8000;
+static const size_t PARALLEL_THRESHOLD = 2000;
+
+static void mulLimbs(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn);
+
+// r = a * b, r is an + bn limbs long
+static void mulBasecase(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	r[an] = mul1(r, a, an, b[0]);
+	for (size_t i = 1; i < bn; i++) {
+		r[an + i] = addMul1(r + i, a, an, b[i]);
+	}
+}
+
+// r = a * a, r is 2 * n limbs long
+// Each cross product a[i] * a[j] is only computed once, then doubled, then the squares a[i] * a[i] are added
+static void sqrBasecase(limb_t *r, const limb_t *a, const size_t n) {
+	memset(r, 0, 2 * n * sizeof(limb_t));
+	for (size_t i = 0; i + 1 < n; i++) {
+		r[n + i] = addMul1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+	}
+
+	limb_t topBit = 0;
+	for (size_t i = 0; i < 2 * n; i++) {
+		const limb_t limb = r[i];
+		r[i] = (limb << 1) | topBit;
+		topBit = limb >> (LIMB_BITS - 1);
+	}
+
+	dlimb_t carry = 0;
+	for (size_t i = 0; i < n; i++) {
+		const dlimb_t square = (dlimb_t)a[i] * a[i];
+		dlimb_t t = (dlimb_t)r[2 * i] + (limb_t)square + carry;
+		r[2 * i] = (limb_t)t;
+		t = (dlimb_t)r[2 * i + 1] + (square >> LIMB_BITS) + (t >> LIMB_BITS);
+		r[2 * i + 1] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+}
+
+// a is at least twice as long as b so multiply b by one bn sized slice of a at a time
+static void mulUnbalanced(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	Scratch scratch;
+	limb_t *part = scratch.take(2 * bn);
+
+	memset(r, 0, (an + bn) * sizeof(limb_t));
+	for (size_t i = 0; i < an; i += bn) {
+		const size_t sliceLength = an - i < bn ? an - i : bn;
+		mulLimbs(part, a + i, sliceLength, b, bn);
+		addLimbs(r + i, r + i, an + bn - i, part, sliceLength + bn);
+	}
+}
+
+// https://en.wikipedia.org/wiki/Karatsuba_algorithm
+// With a = a1 * B^m + a0 and b = b1 * B^m + b0:
+//	a * b = z2 * B^2m + (z1 - z2 - z0) * B^m + z0
+// where z0 = a0 * b0, z2 = a1 * b1 and z1 = (a0 + a1) * (b0 + b1)
+// When squaring the three products are squares too.
+static void mulKaratsuba(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	const bool squaring = a == b && an == bn;
+	const size_t m = an / 2;
+	const size_t a1n = an - m;
+	const size_t b1n = bn - m;
+
+	// z0 and z2 go straight into their places in r
+	mulLimbs(r, a, m, b, m);
+	mulLimbs(r + 2 * m, a + m, a1n, b + m, b1n);
+
+	Scratch scratch;
+	const size_t san = a1n + 1;
+	limb_t *sa = scratch.take(san);
+	sa[a1n] = addLimbs(sa, a + m, a1n, a, m);
+
+	// Squaring passes sa twice, which mulLimbs() squares
+	limb_t *sb = sa;
+	size_t sbn = san;
+	if (!squaring && b1n >= m) {
+		sbn = b1n + 1;
+		sb = scratch.take(sbn);
+		sb[b1n] = addLimbs(sb, b + m, b1n, b, m);
+	}
+	else if (!squaring) {
+		sbn = m + 1;
+		sb = scratch.take(sbn);
+		sb[m] = addLimbs(sb, b, m, b + m, b1n);
+	}
+
+	const size_t zn = san + sbn;
+	limb_t *z1 = scratch.take(zn);
+	mulLimbs(z1, sa, san, sb, sbn);
+	subLimbs(z1, z1, zn, r, 2 * m);
+	subLimbs(z1, z1, zn, r + 2 * m, a1n + b1n);
+
+	addLimbs(r + m, r + m, an + bn - m, z1, normalizedLength(z1, zn));
+}
+
+// Scratch for mulLimbs() of an and bn limbs: Karatsuba takes a little over twice the operands
+// at the top and half that again at each level down
+static void reserveMulScratch(const size_t an, const size_t bn) {
+	workspace().reserve(4 * (an + bn) + 128);
+}
+
+// r = a * b, r is an + bn limbs long and must not overlap a or b
+// Passing the same array for a and b squares it.
+static void mulLimbs(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	if (an < bn) {
+		mulLimbs(r, b, bn, a, an);
+	}
+	else if (bn < KARATSUBA_THRESHOLD) {
+		if (a == b && an == bn) {
+			sqrBasecase(r, a, an);
+		}
+		else {
+			mulBasecase(r, a, an, b, bn);
+		}
+	}
+	else if (an >= 2 * bn) {
+		mulUnbalanced(r, a, an, b, bn);
+	}
+	else {
+		mulKaratsuba(r, a, an, b, bn);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Number theoretic transform
+//
+// https://en.wikipedia.org/wiki/Sch%C3%B6nhage%E2%80%93Strassen_algorithm#Convolution_theorem
+// The limbs themselves are the coefficients.  The convolution is done modulo three
+// primes of the form k * 2^s + 1 and put back together with the Chinese remainder
+// theorem.  A coefficient of the product is below 2^24 * 2^64, which is well below
+// the product of the primes (about 2^92), so it is recovered exactly.
+
+struct NttPrime {
+	uint32_t p;
+	uint32_t generator;
+};
+
+static const NttPrime NTT_PRIMES[3] = {
+	{ 2013265921, 31 },	// 15 * 2^27 + 1
+	{ 1811939329, 13 },	// 27 * 2^26 + 1
+	{ 2113929217, 5 },	// 63 * 2^25 + 1
+};
+
+static const size_t NTT_MAX_LIMBS = (size_t)1 << 25;	// All three primes have 2^25 roots of unity
+
+// Arithmetic modulo a prime below 2^31.
+// mul() is Montgomery multiplication, so it returns a * b / 2^32 mod p.
+class NttField {
+	uint32_t mP;
+	uint32_t mNegInverse;	// -1/p mod 2^32
+	uint32_t mR2;	// 2^64 mod p
+
+public:
+	NttField(const uint32_t p) : mP(p) {
+		uint32_t inverse = p;	// Right to 3 bits, each Newton step doubles that
+		for (int i = 0; i < 4; i++) {
+			inverse *= 2 - p * inverse;
+		}
+		mNegInverse = 0 - inverse;
+
+		const uint64_t r = ((uint64_t)1 << 32) % p;
+		mR2 = (uint32_t)(r * r % p);
+	}
+
+	// x in [-p, p) to [0, p) without a branch, the transforms are too unpredictable for branches
+	uint32_t reduce(const uint32_t x) const {
+		return x + (mP & (0 - (x >> 31)));
+	}
+
+	uint32_t add(const uint32_t a, const uint32_t b) const {
+		return reduce(a + b - mP);
+	}
+
+	uint32_t sub(const uint32_t a, const uint32_t b) const {
+		return reduce(a - b);
+	}
+
+	uint32_t mul(const uint32_t a, const uint32_t b) const {
+		const uint64_t t = (uint64_t)a * b;
+		const uint32_t m = (uint32_t)t * mNegInverse;
+		const uint32_t u = (uint32_t)((t + (uint64_t)m * mP) >> 32);
+		return reduce(u - mP);
+	}
+
+	// a * 2^32 mod p, multiplying by that with mul() multiplies by a
+	uint32_t toMontgomery(const uint32_t a) const {
+		return mul(a, mR2);
+	}
+
+	// base^e with base and result in Montgomery form
+	uint32_t pow(uint32_t base, uint64_t e) const {
+		uint32_t result = toMontgomery(1);
+		for (; e != 0; e >>= 1) {
+			if (e & 1) {
+				result = mul(result, base);
+			}
+			base = mul(base, base);
+		}
+		return result;
+	}
+};
+
+// roots[half + j] = w^j where w is a primitive (2 * half)th root of unity, for each power of two half < n.
+// The roots are in Montgomery form.
+static void nttRoots(uint32_t *roots, const size_t n, const NttField &field, const NttPrime &prime, const bool inverse) {
+	const uint32_t generator = field.toMontgomery(prime.generator);
+	for (size_t half = 1; half < n; half *= 2) {
+		const uint64_t order = (prime.p - 1) / (2 * half);
+		const uint32_t w = field.pow(generator, inverse ? prime.p - 1 - order : order);
+		roots[half] = field.toMontgomery(1);
+		for (size_t j = 1; j < half; j++) {
+			roots[half + j] = field.mul(roots[half + j - 1], w);
+		}
+	}
+}
+
+static const size_t NTT_PARALLEL_BLOCK = (size_t)1 << 14;	// Smaller transforms aren't worth splitting up
+static const size_t NTT_PARALLEL_CHUNK = (size_t)1 << 12;	// Smallest share of a linear pass for one thread
+
+// Decimation in frequency, leaves the result in bit reversed order.
+// After the first stage the two halves are independent transforms, which is how big ones are split across threads.
+static void nttForward(uint32_t *a, const size_t n, const NttField &field, const uint32_t *roots) {
+	if (n > NTT_PARALLEL_BLOCK) {
+		const size_t half = n / 2;
+		parallelRange(half, NTT_PARALLEL_CHUNK, [&](const size_t begin, const size_t end) {
+			for (size_t j = begin; j < end; j++) {
+				const uint32_t u = a[j];
+				const uint32_t v = a[j + half];
+				a[j] = field.add(u, v);
+				a[j + half] = field.mul(field.sub(u, v), roots[half + j]);
+			}
+		});
+		parallelFor(2, [&](const size_t i) {
+			nttForward(a + i * half, half, field, roots);
+		});
+		return;
+	}
+
+	for (size_t half = n / 2; half >= 1; half /= 2) {
+		for (size_t start = 0; start < n; start += 2 * half) {
+			for (size_t j = 0; j < half; j++) {
+				const uint32_t u = a[start + j];
+				const uint32_t v = a[start + j + half];
+				a[start + j] = field.add(u, v);
+				a[start + j + half] = field.mul(field.sub(u, v), roots[half + j]);
+			}
+		}
+	}
+}
+
+// Decimation in time, takes bit reversed order and leaves the result in natural order (not yet divided by n).
+// The mirror image of nttForward(): the halves are independent until the last stage.
+static void nttInverse(uint32_t *a, const size_t n, const NttField &field, const uint32_t *inverseRoots) {
+	if (n > NTT_PARALLEL_BLOCK) {
+		const size_t half = n / 2;
+		parallelFor(2, [&](const size_t i) {
+			nttInverse(a + i * half, half, field, inverseRoots);
+		});
+		parallelRange(half, NTT_PARALLEL_CHUNK, [&](const size_t begin, const size_t end) {
+			for (size_t j = begin; j < end; j++) {
+				const uint32_t u = a[j];
+				const uint32_t v = field.mul(a[j + half], inverseRoots[half + j]);
+				a[j] = field.add(u, v);
+				a[j + half] = field.sub(u, v);
+			}
+		});
+		return;
+	}
+
+	for (size_t half = 1; half < n; half *= 2) {
+		for (size_t start = 0; start < n; start += 2 * half) {
+			for (size_t j = 0; j < half; j++) {
+				const uint32_t u = a[start + j];
+				const uint32_t v = field.mul(a[start + j + half], inverseRoots[half + j]);
+				a[start + j] = field.add(u, v);
+				a[start + j + half] = field.sub(u, v);
+			}
+		}
+	}
+}
+
+// residues = a * b modulo one prime, as an n point cyclic convolution
+static void nttConvolve(uint32_t *residues, const size_t n, const NttPrime &prime, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	const NttField field(prime.p);
+	const bool squaring = a == b && an == bn;
+
+	Scratch scratch;
+	uint32_t *roots = scratch.take(n);
+	uint32_t *inverseRoots = scratch.take(n);
+	nttRoots(roots, n, field, prime, false);
+	nttRoots(inverseRoots, n, field, prime, true);
+
+	uint32_t *fb = squaring ? NULL : scratch.take(n);
+	parallelFor(squaring ? 1 : 2, [&](const size_t i) {
+		uint32_t *f = i == 0 ? residues : fb;
+		const limb_t *x = i == 0 ? a : b;
+		const size_t xn = i == 0 ? an : bn;
+		for (size_t j = 0; j < n; j++) {
+			f[j] = j < xn ? x[j] % prime.p : 0;
+		}
+		nttForward(f, n, field, roots);
+	});
+
+	const uint32_t *pB = squaring ? residues : fb;
+	parallelRange(n, NTT_PARALLEL_CHUNK, [&](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			residues[i] = field.mul(residues[i], pB[i]);
+		}
+	});
+
+	nttInverse(residues, n, field, inverseRoots);
+
+	// The pointwise mul() left a factor of 1/2^32, so scale by 2^32 / n
+	const uint32_t nInverse = prime.p - (prime.p - 1) / (uint32_t)n;
+	const uint32_t scale = field.toMontgomery(field.toMontgomery(nInverse));
+	parallelRange(n, NTT_PARALLEL_CHUNK, [&](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			residues[i] = field.mul(residues[i], scale);
+		}
+	});
+}
+
+static uint64_t powMod64(uint64_t base, uint64_t e, const uint64_t m) {
+	uint64_t result = 1;
+	for (base %= m; e != 0; e >>= 1) {
+		if (e & 1) {
+			result = result * base % m;
+		}
+		base = base * base % m;
+	}
+	return result;
+}
+
+// r = a * b, r is an + bn limbs long and an + bn <= NTT_MAX_LIMBS
+static void mulNtt(limb_t *r, const limb_t *a, const size_t an, const limb_t *b, const size_t bn) {
+	size_t n = 1;
+	while (n < an + bn) {
+		n *= 2;
+	}
+
+	Scratch scratch;
+	uint32_t *residues[3];
+	for (size_t k = 0; k < 3; k++) {
+		residues[k] = scratch.take(n);
+	}
+	parallelFor(3, [&](const size_t k) {
+		nttConvolve(residues[k], n, NTT_PRIMES[k], a, an, b, bn);
+	});
+
+	// Garner's algorithm: value = x1 + p1 * t2 + p1 * p2 * t3
+	// Each value is about 92 bits, they are worked out in parallel and left as three limbs in place of the residues
+	const uint64_t p1 = NTT_PRIMES[0].p;
+	const uint64_t p2 = NTT_PRIMES[1].p;
+	const uint64_t p3 = NTT_PRIMES[2].p;
+	const uint64_t p1InverseModP2 = powMod64(p1, p2 - 2, p2);
+	const uint64_t p1p2 = p1 * p2;
+	const uint64_t p1p2InverseModP3 = powMod64(p1p2, p3 - 2, p3);
+	const uint64_t mask = 0xFFFFFFFF;
+
+	parallelRange(an + bn, NTT_PARALLEL_CHUNK, [&](const size_t begin, const size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			const uint64_t x1 = residues[0][i];
+			const uint64_t x2 = residues[1][i];
+			const uint64_t x3 = residues[2][i];
+
+			const uint64_t t2 = (x2 + p2 - x1 % p2) % p2 * p1InverseModP2 % p2;
+			const uint64_t low = x1 + p1 * t2;
+			const uint64_t t3 = (x3 + p3 - low % p3) % p3 * p1p2InverseModP3 % p3;
+			const uint64_t highLow = (p1p2 & mask) * t3;
+			const uint64_t highHigh = (p1p2 >> 32) * t3;
+
+			const uint64_t limb0 = (low & mask) + (highLow & mask);
+			const uint64_t limb1 = (low >> 32) + (highLow >> 32) + (highHigh & mask) + (limb0 >> 32);
+			const uint64_t limb2 = (highHigh >> 32) + (limb1 >> 32);
+			residues[0][i] = (uint32_t)limb0;
+			residues[1][i] = (uint32_t)limb1;
+			residues[2][i] = (uint32_t)limb2;
+		}
+	});
+
+	// Add them up, value i goes in at limb i
+	uint64_t column0 = 0, column1 = 0, column2 = 0;
+	for (size_t i = 0; i < an + bn; i++) {
+		column0 += residues[0][i];
+		column1 += residues[1][i];
+		column2 += residues[2][i];
+
+		r[i] = (limb_t)column0;
+		column0 = column1 + (column0 >> 32);
+		column1 = column2;
+		column2 = 0;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Division
+//
+// Unsigned::divideRecursive() splits divisions in half until the divisor or the quotient
+// is below DIVIDE_THRESHOLD limbs, then divBasecase() does schoolbook long division.
+
+static const size_t DIVIDE_THRESHOLD = 60;
+
+// A single limb divisor with its reciprocal worked out once, so dividing by it takes
+// multiplies instead of a hardware divide per limb.
+// Moller and Granlund, Improved division by invariant integers, 2011.
+class LimbDivisor {
+	limb_t mD;		// The divisor shifted so its top bit is set
+	limb_t mInverse;	// floor((B^2 - 1) / mD) - B
+	int mShift;
+
+public:
+	explicit LimbDivisor(const limb_t divisor) {
+		mShift = 0;
+		while (((divisor << mShift) >> (LIMB_BITS - 1)) == 0) {
+			mShift++;
+		}
+		mD = divisor << mShift;
+		mInverse = (limb_t)((((dlimb_t)~mD << LIMB_BITS) | (limb_t)~0) / mD);
+	}
+
+	// (high * B + low) / mD where high < mD, the remainder goes in r
+	limb_t divide(const limb_t high, const limb_t low, limb_t &r) const {
+		const dlimb_t estimate = (dlimb_t)mInverse * high + (((dlimb_t)high << LIMB_BITS) | low);
+		limb_t q = (limb_t)(estimate >> LIMB_BITS) + 1;
+		limb_t rem = low - q * mD;
+		if (rem > (limb_t)estimate) {
+			q--;
+			rem += mD;
+		}
+		if (rem >= mD) {
+			q++;
+			rem -= mD;
+		}
+		r = rem;
+		return q;
+	}
+
+	// q = a / divisor, n limbs long, returns the remainder.  q may be a, or NULL for just the remainder.
+	limb_t divideLimbs(limb_t *q, const limb_t *a, const size_t n) const {
+		if (n == 0) return 0;
+
+		// The dividend is shifted along with the divisor a limb at a time
+		limb_t r = mShift == 0 ? 0 : a[n - 1] >> (LIMB_BITS - mShift);
+		for (size_t i = n; i-- > 0;) {
+			const limb_t low = mShift == 0 ? a[i] : (a[i] << mShift) | (i > 0 ? a[i - 1] >> (LIMB_BITS - mShift) : 0);
+			const limb_t digit = divide(r, low, r);
+			if (q != NULL) {
+				q[i] = digit;
+			}
+		}
+		return r >> mShift;
+	}
+};
+
+// Knuth's Algorithm D, The Art of Computer Programming vol 2, 4.3.1.
+// u is un + 1 limbs with u[un] spare for normalizing, v is vn >= 2 limbs with its top bit set.
+// q gets the un - vn + 1 quotient limbs and the remainder is left in the low vn limbs of u.
+static void divBasecase(limb_t *q, limb_t *u, const size_t un, const limb_t *v, const size_t vn) {
+	const dlimb_t base = (dlimb_t)1 << LIMB_BITS;
+	const limb_t vTop = v[vn - 1];
+	const limb_t vNext = v[vn - 2];
+
+	for (size_t j = un - vn + 1; j-- > 0;) {
+		// Estimate the quotient limb from the top of the remainder.  Since v is normalized
+		// it is at most 2 too big and checking against vNext catches nearly all of those.
+		const dlimb_t top = ((dlimb_t)u[j + vn] << LIMB_BITS) | u[j + vn - 1];
+		dlimb_t qhat = top / vTop;
+		dlimb_t rhat = top % vTop;
+		while (qhat >= base || qhat * vNext > ((rhat << LIMB_BITS) | u[j + vn - 2])) {
+			qhat--;
+			rhat += vTop;
+			if (rhat >= base) break;
+		}
+
+		const limb_t borrow = subMul1(u + j, v, vn, (limb_t)qhat);
+		const limb_t high = u[j + vn];
+		u[j + vn] = high - borrow;
+		if (high < borrow) {
+			// Still one too big, which is rare: add v back
+			qhat--;
+			u[j + vn] += addN(u + j, u + j, v, vn);
+		}
+		q[j] = (limb_t)qhat;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Montgomery
+//
+// Montgomery keeps numbers modulo an odd m as a R mod m, R = B^n for an n limb m.  A product
+// of two of them is brought back below m by reduce(), which divides by R instead of m:
+// a multiple of m is added to clear the low n limbs, which then just drop off.
+// Montgomery, Modular multiplication without trial division, 1985.
+//
+// Below MONTGOMERY_THRESHOLD limbs reduce() clears one limb at a time, n^2 like schoolbook.
+// From there it works out the whole multiple with two multiplies, so it scales like multiply().
+
+static const size_t MONTGOMERY_THRESHOLD = 300;
+
+// The window for slidingWindowPower(): k bits need the 2^(k - 1) odd powers below 2^k
+static size_t powWindowBits(const size_t exponentBits) {
+	if (exponentBits <= 8) return 1;
+	if (exponentBits <= 24) return 2;
+	if (exponentBits <= 80) return 3;
+	if (exponentBits <= 240) return 4;
+	if (exponentBits <= 672) return 5;
+	return 6;
+}
+
+// base^exp from one, square(x) and multiply(x, y) in any representation: left to right over
+// the bits of exp, squaring once per bit and multiplying once per window of up to
+// powWindowBits() bits from a one bit down to the lowest one bit in reach.
+template <typename Square, typename Multiply>
+Unsigned Unsigned::slidingWindowPower(const Unsigned &one, const Unsigned &base, const Unsigned &exp,
+	const Square &square, const Multiply &multiply) {
+	const size_t bits = exp.bitLength();
+	const size_t window = powWindowBits(bits);
+
+	// oddPowers[i] = base^(2i + 1)
+	std::vector<Unsigned> oddPowers((size_t)1 << (window - 1));
+	oddPowers[0] = base;
+	if (oddPowers.size() > 1) {
+		const Unsigned baseSquared = square(base);
+		for (size_t i = 1; i < oddPowers.size(); i++) {
+			oddPowers[i] = multiply(oddPowers[i - 1], baseSquared);
+		}
+	}
+
+	Unsigned result(one);
+	for (size_t top = bits; top > 0;) {
+		if (!exp.testBit(top - 1)) {
+			result = square(result);
+			top--;
+			continue;
+		}
+
+		size_t low = top > window ? top - window : 0;
+		while (!exp.testBit(low)) {
+			low++;
+		}
+		for (size_t i = low; i < top; i++) {
+			result = square(result);
+		}
+		result = multiply(result, oddPowers[(exp.bitsAt(low) & (((limb_t)1 << (top - low)) - 1)) >> 1]);
+		top = low;
+	}
+	return result;
+}
+
+// a mod 2^bits
+Unsigned Unsigned::lowBits(const Unsigned &a, const size_t bits) {
+	Unsigned result = a.slice(0, (bits + LIMB_BITS - 1) / LIMB_BITS);
+	if (bits % LIMB_BITS != 0 && result.length() == (bits + LIMB_BITS - 1) / LIMB_BITS) {
+		result.mLimbs[result.length() - 1] &= ((limb_t)1 << (bits % LIMB_BITS)) - 1;
+		result.trim();
+	}
+	return result;
+}
+
+// 1 / a mod 2^bits for odd a, by Newton's iteration y = y (2 - a y) which doubles the
+// correct bits each time
+Unsigned Unsigned::inversePowerOfTwo(const Unsigned &a, const size_t bits) {
+	// a a = 1 mod 8 so a is its own inverse to 3 bits
+	limb_t low = a.mLimbs[0];
+	for (int i = 0; i < 4; i++) {
+		low *= 2 - a.mLimbs[0] * low;
+	}
+
+	Unsigned y((long long)low);
+	for (size_t precision = LIMB_BITS; precision < bits;) {
+		precision = precision * 2 < bits ? precision * 2 : bits;
+
+		// a y = 1 + d with d = 0 to the old precision, and y (1 - d) = y - y d
+		const Unsigned d = lowBits(a * y, precision) - Unsigned(1);
+		Unsigned power;
+		power.setBit(precision);
+		y = lowBits(y + power - lowBits(y * d, precision), precision);
+	}
+	return lowBits(y, bits);
+}
+
+Montgomery::Montgomery(const Unsigned &modulus) : mModulus(modulus), mLength(modulus.length()) {
+	mInverse = 0 - Unsigned::inversePowerOfTwo(modulus, Unsigned::LIMB_BITS).mLimbs[0];
+	if (mLength >= MONTGOMERY_THRESHOLD) {
+		Unsigned r;
+		r.setBit(mLength * Unsigned::LIMB_BITS);
+		mWideInverse = r - Unsigned::inversePowerOfTwo(modulus, mLength * Unsigned::LIMB_BITS);
+	}
+
+	mOne.setBit(mLength * Unsigned::LIMB_BITS);
+	mOne = Unsigned::mod(mOne, mModulus);
+	mRSquared = Unsigned::mod(Unsigned::square(mOne), mModulus);
+}
+
+// t / R mod m for t < m R
+Unsigned Montgomery::reduce(const Unsigned &t) const {
+	const size_t n = mLength;
+	Unsigned result;
+
+	if (n < MONTGOMERY_THRESHOLD) {
+		// Clear a limb at a time: t + u m has limb i zero for u = t[i] (-1 / m)
+		Unsigned::limbs_t &r = result.mLimbs;
+		r.assign(2 * n + 1, 0);
+		for (size_t i = 0; i < t.length(); i++) {
+			r[i] = t.mLimbs[i];
+		}
+		for (size_t i = 0; i < n; i++) {
+			const Unsigned::limb_t carry = addMul1(&r[i], &mModulus.mLimbs[0], n, r[i] * mInverse);
+			add1(&r[i + n], &r[i + n], n + 1 - i, carry);
+		}
+		r.eraseLow(n);
+		result.trim();
+	}
+	else {
+		// The same for all n limbs at once: u = t (-1 / m) mod R
+		const Unsigned u = Unsigned::multiply(t.slice(0, n), mWideInverse).slice(0, n);
+		result = t + Unsigned::multiply(u, mModulus);
+		if (result.length() > n) {
+			result.mLimbs.eraseLow(n);
+		}
+		else {
+			result.mLimbs.clear();	// t + u m is 0 or at least R
+		}
+	}
+
+	// t + u m < 2 m R so the result is below 2 m
+	if (result >= mModulus) {
+		Unsigned::subtractMutable(result, mModulus);
+	}
+	return result;
+}
+
+// a R mod m
+Unsigned Montgomery::toMontgomery(const Unsigned &a) const {
+	return reduce(Unsigned::multiply(a < mModulus ? a : Unsigned::mod(a, mModulus), mRSquared));
+}
+
+Unsigned Montgomery::fromMontgomery(const Unsigned &a) const {
+	return reduce(a);
+}
+
+// a b / R mod m: the Montgomery form of the product of two numbers in Montgomery form
+Unsigned Montgomery::mulMod(const Unsigned &a, const Unsigned &b) const {
+	return reduce(Unsigned::multiply(a, b));
+}
+
+Unsigned Montgomery::sqrMod(const Unsigned &a) const {
+	return reduce(Unsigned::square(a));
+}
+
+// base^exp mod m with base and the result as ordinary numbers
+Unsigned Montgomery::powMod(const Unsigned &base, const Unsigned &exp) const {
+	const Unsigned power = Unsigned::slidingWindowPower(mOne, toMontgomery(base), exp,
+		[this](const Unsigned &a) { return sqrMod(a); },
+		[this](const Unsigned &a, const Unsigned &b) { return mulMod(a, b); });
+	return fromMontgomery(power);
+}
+
+//------------------------------------------------------------------------------
+// Unsigned
+//
+// Numbers are stored in binary as base 2^32 limbs, least significant limb first.
+// A trimmed number has no leading (most significant) zero limbs so zero has no limbs at all.
+
+static Unsigned gUnsignedZero(0);
+static Unsigned gUnsignedOne(1);
+static Unsigned gUnsignedTwo(2);
+
+static const Unsigned::limb_t DECIMAL_CHUNK = 1000000000;	// Largest power of 10 that fits in a limb
+static const int DECIMAL_CHUNK_DIGITS = 9;
+static const size_t DECIMAL_THRESHOLD = 40;	// Limbs before decimal conversion goes divide and conquer
+
+bool Unsigned::isZero() const {
+	return length() == 0;
+}
+
+bool Unsigned::isOne() const {
+	return length() == 1 && mLimbs[0] == 1;
+}
+
+bool Unsigned::isTwo() const {
+	return length() == 1 && mLimbs[0] == 2;
+}
+
+inline bool isOdd(const int n) { return n % 2 != 0; }
+
+inline bool isEven(const int n) { return ! isOdd(n); }
+
+bool Unsigned::isOdd() const {
+	if (length() == 0) return false;
+	return (mLimbs[0] & 1) != 0;
+}
+
+bool Unsigned::isEven() const {
+	return ! isOdd();
+}
+
+// Remove the leading zero limbs
+void Unsigned::trim() {
+	while (!mLimbs.empty() && mLimbs.back() == 0) {
+		mLimbs.pop_back();
+	}
+}
+
+size_t Unsigned::bitLength() const {
+	if (length() == 0) return 0;
+
+	size_t bits = (length() - 1) * LIMB_BITS;
+	for (limb_t top = mLimbs.back(); top != 0; top >>= 1) {
+		bits++;
+	}
+	return bits;
+}
+
+bool Unsigned::testBit(const size_t bit) const {
+	const size_t i = bit / LIMB_BITS;
+	if (i >= length()) return false;
+	return ((mLimbs[i] >> (bit % LIMB_BITS)) & 1) != 0;
+}
+
+void Unsigned::setBit(const size_t bit) {
+	const size_t i = bit / LIMB_BITS;
+	if (i >= length()) {
+		mLimbs.resize(i + 1, 0);
+	}
+	mLimbs[i] |= (limb_t)1 << (bit % LIMB_BITS);
+}
+
+// this <<= bits
+void Unsigned::shiftLeft(const size_t bits) {
+	if (isZero() || bits == 0) return;
+
+	const size_t limbShift = bits / LIMB_BITS;
+	const int bitShift = (int)(bits % LIMB_BITS);
+
+	if (bitShift != 0) {
+		limb_t carry = 0;
+		for (size_t i = 0; i < length(); i++) {
+			const limb_t limb = mLimbs[i];
+			mLimbs[i] = (limb << bitShift) | carry;
+			carry = limb >> (LIMB_BITS - bitShift);
+		}
+		if (carry != 0) {
+			append(carry);
+		}
+	}
+
+	if (limbShift != 0) {
+		mLimbs.insertLow(limbShift);
+	}
+}
+
+// this >>= bits
+void Unsigned::shiftRight(const size_t bits) {
+	const size_t limbShift = bits / LIMB_BITS;
+	const int bitShift = (int)(bits % LIMB_BITS);
+
+	if (limbShift >= length()) {
+		clear();
+		return;
+	}
+
+	if (limbShift != 0) {
+		mLimbs.eraseLow(limbShift);
+	}
+
+	if (bitShift != 0) {
+		for (size_t i = 0; i < length(); i++) {
+			const limb_t next = i + 1 < length() ? mLimbs[i + 1] : 0;
+			mLimbs[i] = (mLimbs[i] >> bitShift) | (next << (LIMB_BITS - bitShift));
+		}
+	}
+
+	trim();
+}
+
+// this = this * mul + add
+void Unsigned::multiplyAddSmall(const limb_t mul, const limb_t add) {
+	dlimb_t carry = add;
+	for (size_t i = 0; i < length(); i++) {
+		const dlimb_t t = (dlimb_t)mLimbs[i] * mul + carry;
+		mLimbs[i] = (limb_t)t;
+		carry = t >> LIMB_BITS;
+	}
+	if (carry != 0) {
+		append((limb_t)carry);
+	}
+	trim();
+}
+
+// this /= divisor, returns the remainder
+Unsigned::limb_t Unsigned::divideSmall(const limb_t divisor) {
+	if (isZero()) return 0;
+
+	const limb_t rem = LimbDivisor(divisor).divideLimbs(&mLimbs[0], &mLimbs[0], length());
+	trim();
+	return rem;
+}
+
+int Unsigned::charToInt(const char c) {
+	return c - '0';
+}
+
+char Unsigned::intToChar(const int n) {
+	if (n < 0) return '^';
+	return (char)(n + '0');
+}
+
+void Unsigned::clear() {
+	mLimbs.clear();
+}
+
+void Unsigned::mkError() {
+	clear();	// Doesn't really set an error.  But will case unit tests to fail which should raise a flag.
+}
+
+// 10^(DECIMAL_CHUNK_DIGITS * 2^level), each level the square of the one before.
+// The powers are kept for every later conversion.  A deque never moves its elements
+// so references handed out stay good while other threads add levels.
+static const Unsigned &decimalPower(const size_t level) {
+	static std::mutex lock;
+	static std::deque<Unsigned> powers;
+
+	std::lock_guard<std::mutex> guard(lock);
+	const LimbAllocatorScope scope(LimbAllocator::standard());	// Outlives any arena
+	if (powers.empty()) {
+		powers.push_back(Unsigned());
+		powers.back().setULongLong(DECIMAL_CHUNK);
+	}
+	while (powers.size() <= level) {
+		powers.push_back(Unsigned::square(powers.back()));
+	}
+	return powers[level];
+}
+
+// Number of decimal digits in decimalPower(level)
+static size_t decimalPowerDigits(const size_t level) {
+	return (size_t)DECIMAL_CHUNK_DIGITS << level;
+}
+
+// Reads up to DECIMAL_CHUNK_DIGITS digits at a time into the binary limbs
+Unsigned Unsigned::fromDecimalBasecase(const char *s, const size_t n) {
+	Unsigned result;
+
+	limb_t chunk = 0;
+	limb_t chunkScale = 1;
+	for (size_t i = 0; i < n; i++) {
+		chunk = chunk * 10 + charToInt(s[i]);
+		chunkScale *= 10;
+		if (chunkScale == DECIMAL_CHUNK) {
+			result.multiplyAddSmall(chunkScale, chunk);
+			chunk = 0;
+			chunkScale = 1;
+		}
+	}
+
+	if (chunkScale > 1) {
+		result.multiplyAddSmall(chunkScale, chunk);
+	}
+	return result;
+}
+
+// Long strings are split so the low part is a power of two chunks long,
+// then high * 10^low digits + low with the power from decimalPower()
+Unsigned Unsigned::fromDecimal(const char *s, const size_t n) {
+	if (n <= DECIMAL_THRESHOLD * DECIMAL_CHUNK_DIGITS) {
+		return fromDecimalBasecase(s, n);
+	}
+
+	size_t level = 0;
+	while (decimalPowerDigits(level + 1) < n) {
+		level++;
+	}
+	const size_t lowDigits = decimalPowerDigits(level);
+
+	Unsigned result = multiply(fromDecimal(s, n - lowDigits), decimalPower(level));
+	result.add(fromDecimal(s + n - lowDigits, lowDigits));
+	return result;
+}
+
+void Unsigned::saveNumber(const char *s) {
+	clear();
+
+	for (const char *p = s; *p; p++) {
+		if (*p == '.') {
+			fprintf(stderr, "Decimals are not supported -- only integers: %s\n", s);
+			mkError();
+			return;
+		}
+
+		if (!isdigit(*p)) {
+			fprintf(stderr, "Invalid number: %s\n", s);
+			mkError();
+			return;
+		}
+	}
+
+	set(fromDecimal(s, strlen(s)));
+}
+
+// Peels off DECIMAL_CHUNK_DIGITS digits at a time, least significant first.
+// With minDigits the result is padded with leading zeros to at least that many digits.
+void Unsigned::appendDecimalBasecase(std::string &out, const Unsigned &a, const size_t minDigits) {
+	// Each chunk takes 29.9 bits off, so there are at most 1.07 chunks to a limb
+	Scratch scratch;
+	size_t n = a.length();
+	limb_t *working = scratch.take(n);
+	limb_t *chunks = scratch.take(n + n / 8 + 1);
+	if (n > 0) {
+		memcpy(working, &a.mLimbs[0], n * sizeof(limb_t));
+	}
+
+	const LimbDivisor divisor(DECIMAL_CHUNK);
+	size_t count = 0;
+	while (n > 0) {
+		chunks[count++] = divisor.divideLimbs(working, working, n);
+		n = normalizedLength(working, n);
+	}
+
+	std::string digits = "";
+	char buf[DECIMAL_CHUNK_DIGITS + 1];
+	for (size_t i = count; i-- > 0;) {
+		limb_t chunk = chunks[i];
+		int pos = DECIMAL_CHUNK_DIGITS;
+		buf[pos] = '\0';
+		do {
+			buf[--pos] = intToChar(chunk % 10);
+			chunk /= 10;
+		} while (pos > 0 && (chunk != 0 || i + 1 < count));
+		digits += &buf[pos];
+	}
+
+	if (digits.length() < minDigits) {
+		out.append(minDigits - digits.length(), '0');
+	}
+	out += digits;
+}
+
+// Divides by a power of ten about half a's size and converts the quotient and the remainder.
+// Each level of the split costs a few big divisions so the whole thing scales like multiply().
+void Unsigned::appendDecimal(std::string &out, const Unsigned &a, const size_t minDigits) {
+	if (a.length() <= DECIMAL_THRESHOLD) {
+		appendDecimalBasecase(out, a, minDigits);
+		return;
+	}
+
+	size_t level = 0;
+	while (2 * decimalPower(level + 1).length() <= a.length() + 1) {
+		level++;
+	}
+	const size_t lowDigits = decimalPowerDigits(level);
+
+	const UnsignedDivide qr = divideWithRemFast(a, decimalPower(level));
+	appendDecimal(out, qr.quotient, minDigits > lowDigits ? minDigits - lowDigits : 0);
+	appendDecimal(out, qr.remainder, lowDigits);
+}
+
+std::string Unsigned::toString() const {
+	if (isZero()) return "0";
+
+	std::string out = "";
+	appendDecimal(out, *this, 0);
+	return out;
+}
+
+unsigned long long Unsigned::toULongLong() const {
+	unsigned long long n = 0;
+	for (size_t i = length(); i-- > 0;) {
+		n = (n << LIMB_BITS) | mLimbs[i];
+	}
+	return n;
+}
+
+int Unsigned::toInt() const {
+	return (int)toULongLong();
+}
+
+long Unsigned::toLong() const {
+	return (long)toULongLong();
+}
+
+long long Unsigned::toLongLong() const {
+	return (long long)toULongLong();
+}
+
+void Unsigned::setULongLong(const unsigned long long n) {
+	clear();
+	for (unsigned long long rest = n; rest != 0; rest >>= LIMB_BITS) {
+		append((limb_t)rest);
+	}
+}
+
+void Unsigned::set(const Unsigned &in) {
+	mLimbs = in.mLimbs;
+}
+
+void Unsigned::set(Unsigned &&in) {
+	mLimbs = std::move(in.mLimbs);
+}
+
+Unsigned::Unsigned(const Unsigned &in) {
+	set(in);
+}
+
+Unsigned::Unsigned(Unsigned &&in) noexcept : mLimbs(std::move(in.mLimbs)) {
+}
+
+Unsigned::Unsigned(const char *in) {
+	saveNumber(in);
+}
+
+Unsigned::Unsigned(const int n) {
+	if (n < 0) {
+		fprintf(stderr, "Invalid number: %d\n", n);
+		mkError();
+		return;
+	}
+	setULongLong(n);
+}
+
+Unsigned::Unsigned(const long n) {
+	if (n < 0) {
+		fprintf(stderr, "Invalid number: %ld\n", n);
+		mkError();
+		return;
+	}
+	setULongLong(n);
+}
+
+Unsigned::Unsigned(const long long n) {
+	if (n < 0) {
+		fprintf(stderr, "Invalid number: %lld\n", n);
+		mkError();
+		return;
+	}
+	setULongLong(n);
+}
+
+Unsigned::Unsigned(const bool b) {
+	set((int)b);
+}
+
+// a += b
+inline void Unsigned::addMutable(Unsigned &workingA, const Unsigned &b) {
+	const size_t bLength = b.length();
+	if (workingA.length() < bLength) {
+		workingA.mLimbs.resize(bLength, 0);
+	}
+
+	if (bLength == 0) return;
+
+	limb_t *r = &workingA.mLimbs[0];
+	const limb_t carry = addLimbs(r, r, workingA.length(), &b.mLimbs[0], bLength);
+	if (carry > 0) {
+		workingA.append(carry);
+	}
+}
+
+// result = a + b
+Unsigned Unsigned::add(const Unsigned &a, const Unsigned &b) {
+	Unsigned workingA(a);
+
+	addMutable(workingA, b);
+
+	return workingA;
+}
+
+// a -= b
+void Unsigned::subtractMutable(Unsigned &workingA, const Unsigned &b) {
+	const size_t bLength = b.length();
+	if (workingA.length() < bLength) {
+		workingA.mLimbs.resize(bLength, 0);
+	}
+
+	if (bLength == 0) return;
+
+	limb_t *r = &workingA.mLimbs[0];
+	const limb_t borrow = subLimbs(r, r, workingA.length(), &b.mLimbs[0], bLength);
+	if (borrow > 0) {
+		fprintf(stderr, "Unsigned::subtract: Should not have a borrow\n");
+		workingA.mkError();
+	}
+
+	workingA.trim();
+}
+
+Unsigned Unsigned::subtract(const Unsigned &a, const Unsigned &b) {
+	Unsigned workingA(a);
+
+	subtractMutable(workingA, b);
+
+	return workingA;
+}
+
+// a = b - a, for a <= b
+void Unsigned::subtractFromMutable(Unsigned &workingA, const Unsigned &b) {
+	const size_t aLength = workingA.length();
+	if (b.length() == 0) return;
+	workingA.mLimbs.resize(b.length(), 0);
+
+	limb_t *r = &workingA.mLimbs[0];
+	const limb_t borrow = subLimbs(r, &b.mLimbs[0], b.length(), r, aLength);
+	if (borrow > 0) {
+		fprintf(stderr, "Unsigned::subtractFrom: Should not have a borrow\n");
+		workingA.mkError();
+	}
+
+	workingA.trim();
+}
+
+// acc += a * b.  While one side is below KARATSUBA_THRESHOLD limbs the schoolbook rows go
+// straight into acc, so the product is never stored on its own.
+void Unsigned::addProductMutable(Unsigned &acc, const Unsigned &a, const Unsigned &b) {
+	if (a.isZero() || b.isZero()) return;
+
+	const Unsigned &longer = a.length() >= b.length() ? a : b;
+	const Unsigned &shorter = a.length() >= b.length() ? b : a;
+	if (shorter.length() >= KARATSUBA_THRESHOLD || &acc == &a || &acc == &b) {
+		if (acc.isZero()) {
+			acc.set(multiply(a, b));
+		}
+		else {
+			addMutable(acc, multiply(a, b));
+		}
+		return;
+	}
+
+	// One limb more than either can hold, so no carry ever leaves acc
+	const size_t n = std::max(acc.length(), longer.length() + shorter.length()) + 1;
+	acc.mLimbs.resize(n, 0);
+	limb_t *r = &acc.mLimbs[0];
+	for (size_t i = 0; i < shorter.length(); i++) {
+		const size_t top = i + longer.length();
+		const limb_t carry = addMul1(r + i, &longer.mLimbs[0], longer.length(), shorter.mLimbs[i]);
+		add1(r + top, r + top, n - top, carry);
+	}
+	acc.trim();
+}
+
+// Limbs [from, from + count) as a number
+Unsigned Unsigned::slice(const size_t from, const size_t count) const {
+	Unsigned result;
+
+	if (from >= length()) return result;
+
+	const size_t sliceLength = length() - from < count ? length() - from : count;
+	result.mLimbs.resize(sliceLength, 0);
+	memcpy(&result.mLimbs[0], &mLimbs[from], sliceLength * sizeof(limb_t));
+	result.trim();
+	return result;
+}
+
+// this += a * B^limbs
+void Unsigned::addShifted(const Unsigned &a, const size_t limbs) {
+	if (a.isZero()) return;
+
+	if (length() < limbs + a.length()) {
+		mLimbs.resize(limbs + a.length(), 0);
+	}
+
+	const limb_t carry = addLimbs(&mLimbs[limbs], &mLimbs[limbs], length() - limbs, &a.mLimbs[0], a.length());
+	if (carry != 0) {
+		append(carry);
+	}
+}
+
+// a << bits
+Unsigned Unsigned::shifted(const Unsigned &a, const size_t bits) {
+	Unsigned result(a);
+	result.shiftLeft(bits);
+	return result;
+}
+
+// a * small
+Unsigned Unsigned::scaled(const Unsigned &a, const limb_t small) {
+	Unsigned result(a);
+	result.multiplyAddSmall(small, 0);
+	return result;
+}
+
+// |a - b|, negative is set if a < b
+Unsigned Unsigned::absDifference(const Unsigned &a, const Unsigned &b, bool &negative) {
+	negative = a < b;
+	return negative ? b - a : a - b;
+}
+
+// From the values of a polynomial at x and -x, whose coefficients are all positive:
+//	even = (p(x) + p(-x)) / 2		the even powers
+//	odd = (p(x) - p(-x)) / 2		the odd powers
+void Unsigned::evenAndOdd(const Unsigned &atPlus, const Unsigned &atMinus, const bool minusNegative, Unsigned &even, Unsigned &odd) {
+	if (minusNegative) {
+		even = atPlus - atMinus;
+		odd = atPlus + atMinus;
+	}
+	else {
+		even = atPlus + atMinus;
+		odd = atPlus - atMinus;
+	}
+	even.shiftRight(1);
+	odd.shiftRight(1);
+}
+
+// a is at least twice as long as b so multiply b by one sized slice of a at a time
+Unsigned Unsigned::multiplyUnbalanced(const Unsigned &a, const Unsigned &b) {
+	const size_t nSlices = (a.length() + b.length() - 1) / b.length();
+	std::vector<Unsigned> parts(nSlices);
+
+	if (b.length() >= PARALLEL_THRESHOLD) {
+		parallelFor(nSlices, [&](const size_t i) {
+			parts[i] = multiply(a.slice(i * b.length(), b.length()), b);
+		});
+	}
+	else {
+		for (size_t i = 0; i < nSlices; i++) {
+			parts[i] = multiply(a.slice(i * b.length(), b.length()), b);
+		}
+	}
+
+	Unsigned product;
+	for (size_t i = 0; i < nSlices; i++) {
+		product.addShifted(parts[i], i * b.length());
+	}
+	return product;
+}
+
+// Split x into 3 pieces of m limbs, x = x2 * X^2 + x1 * X + x0 where X = B^m,
+// and evaluate at 0, 1, -1, 2 and infinity.
+// The value at -1 is stored as an absolute value with its sign in negatives[0].
+void Unsigned::evaluateToom3(const Unsigned &x, const size_t m, Unsigned *points, bool *negatives) {
+	const Unsigned x0 = x.slice(0, m);
+	const Unsigned x1 = x.slice(m, m);
+	const Unsigned x2 = x.slice(2 * m, m);
+
+	const Unsigned even = x0 + x2;
+	points[0] = x0;
+	points[1] = even + x1;
+	points[2] = absDifference(even, x1, negatives[0]);
+	points[3] = shifted(shifted(x2, 1) + x1, 1) + x0;
+	points[4] = x2;
+}
+
+// https://en.wikipedia.org/wiki/Toom%E2%80%93Cook_multiplication
+// Treat a and b as degree 2 polynomials in X = B^m, multiply their values at 5 points,
+// then recover the 5 coefficients c0..c4 of the product from those values.
+Unsigned Unsigned::multiplyToom3(const Unsigned &a, const Unsigned &b) {
+	const bool squaring = &a == &b;
+	const size_t m = (a.length() + 2) / 3;
+
+	Unsigned aPoints[5], bPoints[5];
+	bool aNegatives[1], bNegatives[1];
+	evaluateToom3(a, m, aPoints, aNegatives);
+	if (!squaring) {
+		evaluateToom3(b, m, bPoints, bNegatives);
+	}
+
+	Unsigned r[5];
+	const auto pointwise = [&](const size_t i) {
+		r[i] = squaring ? square(aPoints[i]) : multiply(aPoints[i], bPoints[i]);
+	};
+	if (b.length() >= PARALLEL_THRESHOLD) {
+		parallelFor(5, pointwise);
+	}
+	else {
+		for (size_t i = 0; i < 5; i++) {
+			pointwise(i);
+		}
+	}
+	const bool minus1Negative = squaring ? false : aNegatives[0] != bNegatives[0];
+
+	Unsigned even, odd;
+	evenAndOdd(r[1], r[2], minus1Negative, even, odd);	// c0 + c2 + c4, c1 + c3
+
+	const Unsigned &c0 = r[0];
+	const Unsigned &c4 = r[4];
+	const Unsigned c2 = even - c0 - c4;
+
+	Unsigned c3 = r[3] - c0 - shifted(c2, 2) - shifted(c4, 4);	// 2 c1 + 8 c3
+	c3.shiftRight(1);	// c1 + 4 c3
+	c3.subtract(odd);	// 3 c3
+	c3.divideSmall(3);
+	const Unsigned c1 = odd - c3;
+
+	Unsigned product(c0);
+	product.addShifted(c1, m);
+	product.addShifted(c2, 2 * m);
+	product.addShifted(c3, 3 * m);
+	product.addShifted(c4, 4 * m);
+	return product;
+}
+
+// Split x into 4 pieces of m limbs and evaluate at 0, 1, -1, 2, -2, 1/2 and infinity.
+// The value at 1/2 is scaled by 8 to keep it whole: 8 x0 + 4 x1 + 2 x2 + x3.
+// The values at -1 and -2 are stored as absolute values with their signs in negatives[].
+void Unsigned::evaluateToom4(const Unsigned &x, const size_t m, Unsigned *points, bool *negatives) {
+	const Unsigned x0 = x.slice(0, m);
+	const Unsigned x1 = x.slice(m, m);
+	const Unsigned x2 = x.slice(2 * m, m);
+	const Unsigned x3 = x.slice(3 * m, m);
+
+	const Unsigned even1 = x0 + x2;
+	const Unsigned odd1 = x1 + x3;
+	const Unsigned even2 = x0 + shifted(x2, 2);
+	const Unsigned odd2 = shifted(x1 + shifted(x3, 2), 1);
+
+	points[0] = x0;
+	points[1] = even1 + odd1;
+	points[2] = absDifference(even1, odd1, negatives[0]);
+	points[3] = even2 + odd2;
+	points[4] = absDifference(even2, odd2, negatives[1]);
+	points[5] = shifted(shifted(shifted(x0, 1) + x1, 1) + x2, 1) + x3;
+	points[6] = x3;
+}
+
+// Toom-4: like Toom-3 with degree 3 polynomials, 7 points and 7 coefficients c0..c6
+Unsigned Unsigned::multiplyToom4(const Unsigned &a, const Unsigned &b) {
+	const bool squaring = &a == &b;
+	const size_t m = (a.length() + 3) / 4;
+
+	Unsigned aPoints[7], bPoints[7];
+	bool aNegatives[2], bNegatives[2];
+	evaluateToom4(a, m, aPoints, aNegatives);
+	if (!squaring) {
+		evaluateToom4(b, m, bPoints, bNegatives);
+	}
+
+	Unsigned r[7];
+	const auto pointwise = [&](const size_t i) {
+		r[i] = squaring ? square(aPoints[i]) : multiply(aPoints[i], bPoints[i]);
+	};
+	if (b.length() >= PARALLEL_THRESHOLD) {
+		parallelFor(7, pointwise);
+	}
+	else {
+		for (size_t i = 0; i < 7; i++) {
+			pointwise(i);
+		}
+	}
+	const bool minus1Negative = squaring ? false : aNegatives[0] != bNegatives[0];
+	const bool minus2Negative = squaring ? false : aNegatives[1] != bNegatives[1];
+
+	Unsigned even1, odd1, even2, odd2;
+	evenAndOdd(r[1], r[2], minus1Negative, even1, odd1);	// c0 + c2 + c4 + c6, c1 + c3 + c5
+	evenAndOdd(r[3], r[4], minus2Negative, even2, odd2);	// c0 + 4 c2 + 16 c4 + 64 c6, 2 c1 + 8 c3 + 32 c5
+	odd2.shiftRight(1);	// c1 + 4 c3 + 16 c5
+
+	const Unsigned &c0 = r[0];
+	const Unsigned &c6 = r[6];
+
+	const Unsigned sum24 = even1 - c0 - c6;	// c2 + c4
+	Unsigned c4 = even2 - c0 - shifted(c6, 6) - shifted(sum24, 2);	// 12 c4
+	c4.divideSmall(12);
+	const Unsigned c2 = sum24 - c4;
+
+	Unsigned w = r[5] - shifted(c0, 6) - shifted(c2, 4) - shifted(c4, 2) - c6;	// 32 c1 + 8 c3 + 2 c5
+	w.shiftRight(1);	// 16 c1 + 4 c3 + c5
+	Unsigned v = odd2 - odd1;	// 3 c3 + 15 c5
+	v.divideSmall(3);	// c3 + 5 c5
+	const Unsigned x = shifted(odd1, 4) - w;	// 12 c3 + 15 c5
+	Unsigned c5 = scaled(v, 12) - x;	// 45 c5
+	c5.divideSmall(45);
+	const Unsigned c3 = v - scaled(c5, 5);
+	const Unsigned c1 = odd1 - c3 - c5;
+
+	Unsigned product(c0);
+	product.addShifted(c1, m);
+	product.addShifted(c2, 2 * m);
+	product.addShifted(c3, 3 * m);
+	product.addShifted(c4, 4 * m);
+	product.addShifted(c5, 5 * m);
+	product.addShifted(c6, 6 * m);
+	return product;
+}
+
+Unsigned Unsigned::multiply(const Unsigned &a, const Unsigned &b) {
+	if (&a == &b) return square(a);
+
+	const Unsigned &longer = a.length() >= b.length() ? a : b;
+	const Unsigned &shorter = a.length() >= b.length() ? b : a;
+	Unsigned product;
+
+	if (shorter.isZero()) return product;
+
+	if (shorter.length() < TOOM3_THRESHOLD) {
+		product.mLimbs.resize(a.length() + b.length(), 0);
+		reserveMulScratch(longer.length(), shorter.length());
+		mulLimbs(&product.mLimbs[0], &longer.mLimbs[0], longer.length(), &shorter.mLimbs[0], shorter.length());
+		product.trim();
+	}
+	else if (shorter.length() >= NTT_THRESHOLD && a.length() + b.length() <= NTT_MAX_LIMBS) {
+		product.mLimbs.resize(a.length() + b.length(), 0);
+		mulNtt(&product.mLimbs[0], &longer.mLimbs[0], longer.length(), &shorter.mLimbs[0], shorter.length());
+		product.trim();
+	}
+	else if (longer.length() >= 2 * shorter.length()) {
+		product = multiplyUnbalanced(longer, shorter);
+	}
+	else if (shorter.length() < TOOM4_THRESHOLD) {
+		product = multiplyToom3(longer, shorter);
+	}
+	else {
+		product = multiplyToom4(longer, shorter);
+	}
+
+	return product;
+}
+
+Unsigned Unsigned::square(const Unsigned &a) {
+	Unsigned product;
+
+	if (a.isZero()) return product;
+
+	if (a.length() < TOOM3_THRESHOLD) {
+		product.mLimbs.resize(2 * a.length(), 0);
+		reserveMulScratch(a.length(), a.length());
+		mulLimbs(&product.mLimbs[0], &a.mLimbs[0], a.length(), &a.mLimbs[0], a.length());
+		product.trim();
+	}
+	else if (a.length() >= NTT_THRESHOLD && 2 * a.length() <= NTT_MAX_LIMBS) {
+		product.mLimbs.resize(2 * a.length(), 0);
+		mulNtt(&product.mLimbs[0], &a.mLimbs[0], a.length(), &a.mLimbs[0], a.length());
+		product.trim();
+	}
+	else if (a.length() < TOOM4_THRESHOLD) {
+		product = multiplyToom3(a, a);
+	}
+	else {
+		product = multiplyToom4(a, a);
+	}
+
+	return product;
+}
+
+UnsignedDivide Unsigned::divideByOneWithRem(const Unsigned &dividend) {
+	UnsignedDivide result(dividend, 0);
+	return result;
+}
+
+// In binary this is just a shift
+UnsignedDivide Unsigned::divideByTwoWithRem(const Unsigned &dividend) {
+	UnsignedDivide result(dividend, 0);
+
+	if (dividend.isOdd()) {
+		result.remainder = 1;
+	}
+	result.quotient.shiftRight(1);
+
+	return result;
+}
+
+// q = a / b, r = a % b for a normalized b (its top bit set), one limb of quotient at a time
+void Unsigned::divideBasecase(const Unsigned &a, const Unsigned &b, Unsigned &q, Unsigned &r) {
+	const size_t un = a.length();
+	const size_t vn = b.length();
+
+	Scratch scratch;
+	limb_t *u = scratch.take(un + 1);
+	memcpy(u, &a.mLimbs[0], un * sizeof(limb_t));
+	u[un] = 0;
+
+	q.mLimbs.assign(un - vn + 1, 0);
+	divBasecase(&q.mLimbs[0], u, un, &b.mLimbs[0], vn);
+	q.trim();
+
+	r.mLimbs.resize(vn, 0);
+	memcpy(&r.mLimbs[0], u, vn * sizeof(limb_t));
+	r.trim();
+}
+
+// Burnikel and Ziegler's recursive division, as RecursiveDivRem in Brent and Zimmermann's
+// Modern Computer Arithmetic 1.4.3.  b is normalized.  The top half of the quotient comes from
+// dividing the top of a by the top half of b, is corrected by at most 2 with the multiply by
+// the low half of b, and the same again gives the bottom half.  The multiplies are balanced
+// so division scales like multiply() does.
+void Unsigned::divideRecursive(const Unsigned &a, const Unsigned &b, Unsigned &q, Unsigned &r) {
+	const size_t n = b.length();
+
+	if (a < b) {
+		q.clear();
+		r = a;
+		return;
+	}
+
+	const size_t m = a.length() - n;
+	if (n < DIVIDE_THRESHOLD || m < DIVIDE_THRESHOLD) {
+		divideBasecase(a, b, q, r);
+		return;
+	}
+
+	if (m + 1 < n) {
+		// A short quotient only depends on the top of b: with s = n - m - 1 low limbs dropped
+		// from both, b keeps m + 1 limbs with the top bit set and the quotient is at most 2 too big
+		const size_t s = n - m - 1;
+		divideRecursive(a.slice(s, a.length() - s), b.slice(s, n - s), q, r);
+		Unsigned t = multiply(q, b);
+		while (t > a) {
+			subtractMutable(t, b);
+			subtractMutable(q, gUnsignedOne);
+		}
+		r = a - t;
+		return;
+	}
+
+	if (m > n) {
+		// Long division in base B^n: each step divides fewer than 2n limbs by b
+		q.clear();
+		r.clear();
+		const size_t nBlocks = (m + n - 1) / n;
+		for (size_t block = nBlocks; block-- > 0;) {
+			Unsigned part = a.slice(block * n, block == nBlocks - 1 ? a.length() - block * n : n);
+			part.addShifted(r, n);
+
+			Unsigned partQuotient;
+			divideRecursive(part, b, partQuotient, r);
+			q.addShifted(partQuotient, block * n);
+		}
+		return;
+	}
+
+	const size_t k = m / 2;
+	const Unsigned b1 = b.slice(k, n - k);
+	const Unsigned b0 = b.slice(0, k);
+
+	Unsigned q1, r1;
+	divideRecursive(a.slice(2 * k, a.length() - 2 * k), b1, q1, r1);
+
+	// a1 = r1 * B^2k + (a mod B^2k) - q1 * b0 * B^k, adding b * B^k while q1 is too big
+	Unsigned a1 = a.slice(0, 2 * k);
+	a1.addShifted(r1, 2 * k);
+	Unsigned t = multiply(q1, b0);
+	t.shiftLeft(k * LIMB_BITS);
+	while (a1 < t) {
+		a1.addShifted(b, k);
+		subtractMutable(q1, gUnsignedOne);
+	}
+	subtractMutable(a1, t);
+
+	Unsigned q0, r0;
+	divideRecursive(a1.slice(k, a1.length() - k), b1, q0, r0);
+
+	r = a1.slice(0, k);
+	r.addShifted(r0, k);
+	t = multiply(q0, b0);
+	while (r < t) {
+		r.add(b);
+		subtractMutable(q0, gUnsignedOne);
+	}
+	subtractMutable(r, t);
+
+	q = q0;
+	q.addShifted(q1, k);
+}
+
+// Any divisor that fits in a limb, in one pass over the dividend.  Powers of two are a shift.
+UnsignedDivide Unsigned::divideWithRemSmall(const Unsigned &dividend, const limb_t divisor) {
+	UnsignedDivide	result;
+
+	if (divisor == 0) {
+		fprintf(stderr, "Division by zero\n");
+		result.quotient.mkError();
+		return result;
+	}
+
+	if ((divisor & (divisor - 1)) == 0) {
+		int bits = 0;
+		while (((limb_t)1 << bits) != divisor) {
+			bits++;
+		}
+		result.quotient = dividend;
+		result.quotient.shiftRight(bits);
+		result.remainder.setULongLong(dividend.isZero() ? 0 : dividend.mLimbs[0] & (divisor - 1));
+		return result;
+	}
+
+	result.quotient = dividend;
+	result.remainder.setULongLong(result.quotient.divideSmall(divisor));
+	return result;
+}
+
+// a % divisor without building the quotient
+Unsigned::limb_t Unsigned::modSmall(const Unsigned &a, const limb_t divisor) {
+	if (divisor == 0) {
+		fprintf(stderr, "Division by zero\n");
+		return 0;
+	}
+	if (a.isZero()) return 0;
+
+	return LimbDivisor(divisor).divideLimbs(NULL, &a.mLimbs[0], a.length());
+}
+
+// Normalizes the divisor so its top bit is set, the remainder gets shifted back at the end
+UnsignedDivide Unsigned::divideWithRemFast(const Unsigned &dividend, const Unsigned &divisor) {
+	UnsignedDivide	result;
+
+	if (divisor.length() <= 1) {
+		return divideWithRemSmall(dividend, divisor.isZero() ? 0 : divisor.mLimbs[0]);
+	}
+
+	if (dividend < divisor) {
+		result.remainder = dividend;
+		return result;
+	}
+
+	const size_t shift = (LIMB_BITS - divisor.bitLength() % LIMB_BITS) % LIMB_BITS;
+	divideRecursive(shifted(dividend, shift), shifted(divisor, shift), result.quotient, result.remainder);
+	result.remainder.shiftRight(shift);
+
+	result.trim();
+	return result;
+}
+
+Unsigned Unsigned::divide(const Unsigned &a, const Unsigned &b) {
+	return divideWithRemFast(a, b).quotient;
+}
+
+Unsigned Unsigned::half(const Unsigned &a) {
+	return divideByTwoWithRem(a).quotient;
+}
+
+Unsigned Unsigned::mod(const Unsigned &a, const Unsigned &b) {
+	return divideWithRemFast(a, b).remainder;
+}
+
+Unsigned Unsigned::pow(const Unsigned &a, const Unsigned &n) {
+	if (n.isZero()) return gUnsignedOne;
+	if (a.isZero() || a.isOne()) return a;
+
+	// a = odd * 2^twos, and the power of two is a shift.  Returns 0, which no power of a
+	// nonzero number is, when the shift count wouldn't fit in a size_t.
+	size_t twos = 0;
+	while (!a.testBit(twos)) {
+		twos++;
+	}
+	if (twos > 0) {
+		if (n.length() > 2 || n.toULongLong() > SIZE_MAX / twos) {
+			fprintf(stderr, "Too big for a power: %s ^ %s\n", a.toString().c_str(), n.toString().c_str());
+			return 0;
+		}
+		Unsigned odd(a);
+		odd.shiftRight(twos);
+		return shifted(pow(odd, n), twos * (size_t)n.toULongLong());
+	}
+
+	// Small enough for native arithmetic
+	if (n.length() == 1 && a.length() == 1 && a.bitLength() * n.mLimbs[0] <= 64) {
+		unsigned long long power = 1;
+		for (limb_t i = 0; i < n.mLimbs[0]; i++) {
+			power *= a.mLimbs[0];
+		}
+		Unsigned result;
+		result.setULongLong(power);
+		return result;
+	}
+
+	return slidingWindowPower(gUnsignedOne, a, n,
+		[](const Unsigned &x) { return square(x); },
+		[](const Unsigned &x, const Unsigned &y) { return multiply(x, y); });
+}
+
+// Unsigned::gcd() runs Euclid's algorithm with Lehmer's speedup: most quotients are worked
+// out from the top limb alone and applied to the full numbers in one pass.  From
+// GCD_HALF_THRESHOLD limbs halfGcd() cuts both numbers to half their length with a
+// recursion that does its work on the top halves, so big gcds scale like multiply().
+// halfGcd() goes down to plain Euclid steps below HALF_GCD_THRESHOLD limbs.
+
+static const size_t GCD_HALF_THRESHOLD = 600;
+static const size_t HALF_GCD_THRESHOLD = 200;
+
+// A product of Euclid steps, (a, b) = M (alpha, beta).  The entries are never negative and
+// det = u0 v1 - u1 v0 is 1 or -1.
+class GcdMatrix {
+public:
+	Unsigned u0, u1, v0, v1;
+	int det;
+
+	GcdMatrix() : u0(1), u1(0), v0(0), v1(1), det(1) { }
+	bool isIdentity() const { return u1.isZero() && v0.isZero(); }
+
+	// this = this * m
+	void multiply(const GcdMatrix &m) {
+		const Unsigned newU0 = u0 * m.u0 + u1 * m.v0;
+		const Unsigned newU1 = u0 * m.u1 + u1 * m.v1;
+		const Unsigned newV0 = v0 * m.u0 + v1 * m.v0;
+		const Unsigned newV1 = v0 * m.u1 + v1 * m.v1;
+		u0 = newU0;
+		u1 = newU1;
+		v0 = newV0;
+		v1 = newV1;
+		det *= m.det;
+	}
+};
+
+// LIMB_BITS bits of this starting at bit shift
+Unsigned::limb_t Unsigned::bitsAt(const size_t shift) const {
+	const size_t i = shift / LIMB_BITS;
+	const dlimb_t low = i < length() ? mLimbs[i] : 0;
+	const dlimb_t high = i + 1 < length() ? mLimbs[i + 1] : 0;
+	return (limb_t)(((high << LIMB_BITS) | low) >> (shift % LIMB_BITS));
+}
+
+// Lehmer's inner loop, Knuth's Algorithm L: runs Euclid on the top limb of x and the same
+// bits of y, x >= y, for as long as the quotients are certain to match the full numbers'.
+// Returns false when not even one was, otherwise x, y = a x + b y, c x + d y.
+static bool lehmerStep(const limb_t xTop, const limb_t yTop, int64_t &a, int64_t &b, int64_t &c, int64_t &d) {
+	int64_t x = xTop;
+	int64_t y = yTop;
+	a = 1;
+	b = 0;
+	c = 0;
+	d = 1;
+
+	while (y != 0 && y + c != 0 && y + d != 0) {
+		const int64_t q = (x + a) / (y + c);
+		if (q != (x + b) / (y + d)) break;
+
+		int64_t t = a - q * c;
+		a = c;
+		c = t;
+		t = b - q * d;
+		b = d;
+		d = t;
+		t = x - q * y;
+		x = y;
+		y = t;
+	}
+
+	return b != 0;
+}
+
+// a x + b y where a and b have opposite signs and the result isn't negative
+static Unsigned lehmerCombine(const Unsigned &x, const Unsigned &y, const int64_t a, const int64_t b) {
+	const Unsigned ax = Unsigned::multiply(x, Unsigned((long long)(a < 0 ? -a : a)));
+	const Unsigned by = Unsigned::multiply(y, Unsigned((long long)(b < 0 ? -b : b)));
+	return a > 0 || b < 0 ? ax - by : by - ax;
+}
+
+// |a| x + |b| y, how the cofactors combine
+static Unsigned lehmerSum(const Unsigned &x, const Unsigned &y, const int64_t a, const int64_t b) {
+	return Unsigned::multiply(x, Unsigned((long long)(a < 0 ? -a : a))) + Unsigned::multiply(y, Unsigned((long long)(b < 0 ? -b : b)));
+}
+
+// One step of halfGcd(): takes the bigger of a and b down by a multiple of the other while
+// both stay above limit.  Returns false when they are within limit of each other.
+bool Unsigned::halfGcdStep(Unsigned &a, Unsigned &b, const Unsigned &limit, GcdMatrix &m) {
+	const bool aBigger = a > b;
+	Unsigned &big = aBigger ? a : b;
+	const Unsigned &small = aBigger ? b : a;
+
+	if (big - small <= limit) return false;
+
+	const Unsigned q = divide(big - limit - gUnsignedOne, small);
+	subtractMutable(big, q * small);
+	if (aBigger) {
+		m.u1.add(q * m.u0);
+		m.v1.add(q * m.v0);
+	}
+	else {
+		m.u0.add(q * m.u1);
+		m.v0.add(q * m.v1);
+	}
+	return true;
+}
+
+// Lehmer's speedup for halfGcd(): several Euclid steps from the top limb of the bigger
+// number, unless that would take the smaller one down to limit
+bool Unsigned::halfGcdLehmer(Unsigned &a, Unsigned &b, const Unsigned &limit, GcdMatrix &m) {
+	const bool aBigger = a >= b;
+	Unsigned &x = aBigger ? a : b;
+	Unsigned &y = aBigger ? b : a;
+
+	const size_t bits = x.bitLength();
+	const size_t shift = bits > (size_t)LIMB_BITS ? bits - LIMB_BITS : 0;
+	int64_t ca, cb, cc, cd;
+	if (!lehmerStep(x.bitsAt(shift), y.bitsAt(shift), ca, cb, cc, cd)) return false;
+
+	const Unsigned newY = lehmerCombine(x, y, cc, cd);
+	if (newY <= limit) return false;
+	x = lehmerCombine(x, y, ca, cb);
+	y = newY;
+
+	// (x, y) = q (new x, new y) is the inverse of the Lehmer matrix, whose determinant is 1 or -1
+	GcdMatrix q;
+	q.u0 = Unsigned((long long)(cd < 0 ? -cd : cd));
+	q.u1 = Unsigned((long long)(cb < 0 ? -cb : cb));
+	q.v0 = Unsigned((long long)(cc < 0 ? -cc : cc));
+	q.v1 = Unsigned((long long)(ca < 0 ? -ca : ca));
+	q.det = (uint64_t)ca * (uint64_t)cd - (uint64_t)cb * (uint64_t)cc == 1 ? 1 : -1;
+	if (!aBigger) {
+		std::swap(q.u0, q.v1);
+		std::swap(q.u1, q.v0);
+	}
+	m.multiply(q);
+	return true;
+}
+
+// high + det * (x1 * y1 - x2 * y2), which the caller knows isn't negative
+static Unsigned gcdCombine(const Unsigned &high, const Unsigned &x1, const Unsigned &y1, const Unsigned &x2, const Unsigned &y2, const int det) {
+	Unsigned plus = x1 * y1;
+	Unsigned minus = x2 * y2;
+	if (det < 0) {
+		std::swap(plus, minus);
+	}
+
+	Unsigned result(high);
+	result.add(plus);
+	result.subtract(minus);
+	return result;
+}
+
+// Runs halfGcd() on a and b without their low p limbs and applies the result to all of a and b
+void Unsigned::halfGcdTop(Unsigned &a, Unsigned &b, const size_t p, GcdMatrix &m) {
+	Unsigned aHigh = a.slice(p, a.length());
+	Unsigned bHigh = b.slice(p, b.length());
+	GcdMatrix top;
+	halfGcd(aHigh, bHigh, top);
+	if (top.isIdentity()) return;
+
+	// (a, b) = top^-1 (a, b) and the low limbs only need the small top matrix
+	const Unsigned aLow = a.slice(0, p);
+	const Unsigned bLow = b.slice(0, p);
+	a = gcdCombine(shifted(aHigh, p * LIMB_BITS), top.v1, aLow, top.u1, bLow, top.det);
+	b = gcdCombine(shifted(bHigh, p * LIMB_BITS), top.u0, bLow, top.v0, aLow, top.det);
+	m.multiply(top);
+}
+
+// Cuts a and b, n limbs at most, down to just over s = n / 2 + 1 limbs with steps that keep
+// both above B^s.  m collects the steps: (a, b) on entry = m (a, b) on return.
+// Moller, On Schonhage's algorithm and subquadratic integer gcd computation, 2008.
+// The reductions on the top limbs leave a and b above B^s because the top halves stay
+// bigger than the matrix entries, so nothing here can overshoot the Euclid sequence.
+void Unsigned::halfGcd(Unsigned &a, Unsigned &b, GcdMatrix &m) {
+	m = GcdMatrix();
+
+	const size_t n = a.length() > b.length() ? a.length() : b.length();
+	const size_t s = n / 2 + 1;
+	Unsigned limit(1);
+	limit.shiftLeft(s * LIMB_BITS);
+	if (a <= limit || b <= limit) return;
+
+	if (n >= HALF_GCD_THRESHOLD) {
+		halfGcdTop(a, b, n / 2, m);
+		if (!halfGcdStep(a, b, limit, m)) return;
+
+		const size_t n2 = a.length() > b.length() ? a.length() : b.length();
+		halfGcdTop(a, b, 2 * s - n2, m);
+	}
+
+	while (halfGcdLehmer(a, b, limit, m) || halfGcdStep(a, b, limit, m)) {
+	}
+}
+
+// gcd(a, b), and the cofactor for gcdExtended() unless it is NULL.
+// The cofactors of a for x and y are tracked as sizes: Euclid makes their signs alternate.
+Unsigned Unsigned::gcdWithCofactor(const Unsigned &a, const Unsigned &b, Unsigned *cofactor, bool *negative) {
+	Unsigned x(a), y(b);
+	Unsigned sx(1), sy(0);
+	bool xNegative = false;
+
+	while (!y.isZero()) {
+		if (x < y) {
+			std::swap(x, y);
+			std::swap(sx, sy);
+			xNegative = !xNegative;
+			if (y.isZero()) break;	// a was 0
+		}
+
+		if (cofactor == NULL && x.length() <= 2) {
+			// Finish in native integers
+			unsigned long long nx = x.toULongLong();
+			unsigned long long ny = y.toULongLong();
+			while (ny != 0) {
+				const unsigned long long t = nx % ny;
+				nx = ny;
+				ny = t;
+			}
+			x.setULongLong(nx);
+			break;
+		}
+
+		if (y.length() >= GCD_HALF_THRESHOLD) {
+			GcdMatrix m;
+			halfGcd(x, y, m);
+			if (!m.isIdentity()) {
+				if (cofactor != NULL) {
+					const Unsigned newSx = m.v1 * sx + m.u1 * sy;
+					sy = m.v0 * sx + m.u0 * sy;
+					sx = newSx;
+					xNegative = m.det < 0 ? !xNegative : xNegative;
+				}
+				continue;
+			}
+		}
+		else if (x.length() <= y.length() + 1) {
+			const size_t bits = x.bitLength();
+			const size_t shift = bits > (size_t)LIMB_BITS ? bits - LIMB_BITS : 0;
+			int64_t ca, cb, cc, cd;
+			if (lehmerStep(x.bitsAt(shift), y.bitsAt(shift), ca, cb, cc, cd)) {
+				const Unsigned newX = lehmerCombine(x, y, ca, cb);
+				y = lehmerCombine(x, y, cc, cd);
+				x = newX;
+				if (cofactor != NULL) {
+					const Unsigned newSx = lehmerSum(sx, sy, ca, cb);
+					sy = lehmerSum(sx, sy, cc, cd);
+					sx = newSx;
+					xNegative = (ca != 0 ? ca < 0 : cb > 0) ? !xNegative : xNegative;
+				}
+				continue;
+			}
+		}
+
+		// Euclid step
+		const UnsignedDivide qr = divideWithRemFast(x, y);
+		x = y;
+		y = qr.remainder;
+		if (cofactor != NULL) {
+			const Unsigned newSy = sx + qr.quotient * sy;
+			sx = sy;
+			sy = newSy;
+			xNegative = !xNegative;
+		}
+	}
+
+	if (cofactor != NULL) {
+		*cofactor = sx;
+		*negative = xNegative && !sx.isZero();
+	}
+	return x;
+}
+
+Unsigned Unsigned::gcd(const Unsigned &a, const Unsigned &b) {
+	return gcdWithCofactor(a, b, NULL, NULL);
+}
+
+// gcd(a, b) and s with a * s = gcd (mod b), s is cofactor and negated if negative
+Unsigned Unsigned::gcdExtended(const Unsigned &a, const Unsigned &b, Unsigned &cofactor, bool &negative) {
+	return gcdWithCofactor(a, b, &cofactor, &negative);
+}
+
+// floor(sqrt(n)) for n < 2^64
+static uint64_t sqrt64(const uint64_t n) {
+	uint64_t r = (uint64_t)::sqrt((double)n);
+	if (r > 0xFFFFFFFF) r = 0xFFFFFFFF;
+	while (r * r > n) {
+		r--;
+	}
+	while (r < 0xFFFFFFFF && (r + 1) * (r + 1) <= n) {
+		r++;
+	}
+	return r;
+}
+
+// floor(sqrt(a)), remainder = a - root^2.  Zimmermann's Karatsuba square root: with a
+// shifted so its top quarter is at least beta / 4, a = a3 beta^3 + a2 beta^2 + a1 beta + a0,
+// the root of the top half gives the top half of the root, and one division by twice that
+// gives the rest, off by at most one.
+// Zimmermann, Karatsuba square root, 1999.  Brent and Zimmermann, Modern Computer Arithmetic, 1.5.
+Unsigned Unsigned::sqrtRem(const Unsigned &a, Unsigned &remainder) {
+	if (a.length() <= 2) {
+		const unsigned long long n = a.toULongLong();
+		const unsigned long long root = sqrt64(n);
+		remainder.setULongLong(n - root * root);
+		Unsigned result;
+		result.setULongLong(root);
+		return result;
+	}
+
+	// Shifting by 2 t bits makes the length 4 k or 4 k - 1 bits
+	const size_t bits = a.bitLength();
+	const size_t t = bits % 4 == 1 || bits % 4 == 2 ? 1 : 0;
+	const size_t k = (bits + 2 * t + 3) / 4;
+	const Unsigned normalized = shifted(a, 2 * t);
+
+	Unsigned top(normalized);
+	top.shiftRight(2 * k);
+	Unsigned a1(normalized);
+	a1.shiftRight(k);
+	a1 = lowBits(a1, k);
+	const Unsigned a0 = lowBits(normalized, k);
+
+	Unsigned topRemainder;
+	const Unsigned topRoot = sqrtRem(top, topRemainder);
+	const UnsignedDivide qu = divideWithRemFast(shifted(topRemainder, k) + a1, shifted(topRoot, 1));
+
+	Unsigned root = shifted(topRoot, k) + qu.quotient;
+	remainder = shifted(qu.remainder, k) + a0;
+	const Unsigned qSquared = square(qu.quotient);
+	if (remainder < qSquared) {
+		// root was one too big: (root - 1)^2 = root^2 - 2 root + 1
+		addMutable(remainder, shifted(root, 1));
+		subtractMutable(remainder, gUnsignedOne);
+		subtractMutable(root, gUnsignedOne);
+	}
+	subtractMutable(remainder, qSquared);
+
+	// Undo the shift: 4 (a - (root >> 1)^2) = remainder + 2 root - 1 when root is odd
+	if (t > 0) {
+		if (root.isOdd()) {
+			addMutable(remainder, shifted(root, 1));
+			subtractMutable(remainder, gUnsignedOne);
+		}
+		remainder.shiftRight(2);
+		root.shiftRight(1);
+	}
+	return root;
+}
+
+Unsigned Unsigned::sqrt(const Unsigned &a) {
+	Unsigned remainder;
+	return sqrtRem(a, remainder);
+}
+
+// floor(a^(1/k)) by Newton's iteration x = ((k - 1) x + a / x^(k - 1)) / k, which comes down
+// to the root from above.  Far above it only comes down by a factor (k - 1) / k a step, so the
+// start must be close: the root of the top half of a's bits shifted up, which leaves only the
+// last couple of steps at full size, or for a root of up to 32 bits a floating point estimate.
+Unsigned Unsigned::root(const Unsigned &a, const limb_t k) {
+	if (k == 0) return gUnsignedZero;
+	if (k == 1 || a.isZero() || a.isOne()) return a;
+	if (k == 2) return sqrt(a);
+
+	const size_t bits = a.bitLength();
+	if (k >= bits) return gUnsignedOne;
+
+	// The root has about bits / k bits.  Dropping k h low bits of a leaves root / 2^h.
+	const size_t rootBits = (bits + k - 1) / k;
+	Unsigned x;
+	if (rootBits > 32) {
+		const size_t h = rootBits / 2;
+		Unsigned top(a);
+		top.shiftRight(k * h);
+		x = shifted(root(top, k) + gUnsignedOne, h);
+	}
+	else {
+		const size_t shift = bits > 64 ? bits - 64 : 0;
+		Unsigned top(a);
+		top.shiftRight(shift);
+		// Good to about 1 part in 10^14, so one part in 10^9 more is still above the root
+		const double estimate = ::exp2((::log2((double)top.toULongLong()) + (double)shift) / k);
+		x.setULongLong((unsigned long long)(estimate * (1 + 1e-9)) + 1);
+	}
+
+	const Unsigned kMinusOne((long long)(k - 1));
+	const Unsigned kBig((long long)k);
+	for (;;) {
+		const Unsigned next = divide(multiply(x, kMinusOne) + divide(a, pow(x, kMinusOne)), kBig);
+		if (next >= x) return x;
+		x = next;
+	}
+}
+
+// Squares mod 64, 63, 65 and 11: a number that isn't a square mod one of them isn't a square,
+// which rules out all but about 1 in 100 numbers without a square root
+class SquareResidues {
+public:
+	static const limb_t MODULUS = 63 * 65 * 11;
+	bool mod64[64], mod63[63], mod65[65], mod11[11];
+
+	SquareResidues() {
+		for (limb_t i = 0; i < 64; i++) mod64[i] = false;
+		for (limb_t i = 0; i < 63; i++) mod63[i] = false;
+		for (limb_t i = 0; i < 65; i++) mod65[i] = false;
+		for (limb_t i = 0; i < 11; i++) mod11[i] = false;
+		for (limb_t i = 0; i < 65; i++) {
+			mod64[i * i % 64] = true;
+			mod63[i * i % 63] = true;
+			mod65[i * i % 65] = true;
+			mod11[i * i % 11] = true;
+		}
+	}
+};
+
+bool Unsigned::isPerfectSquare(const Unsigned &a) {
+	static const SquareResidues residues;
+
+	if (a.isZero()) return true;
+	if (!residues.mod64[a.mLimbs[0] % 64]) return false;
+
+	const limb_t r = modSmall(a, SquareResidues::MODULUS);
+	if (!residues.mod63[r % 63] || !residues.mod65[r % 65] || !residues.mod11[r % 11]) return false;
+
+	Unsigned remainder;
+	sqrtRem(a, remainder);
+	return remainder.isZero();
+}
+
+// Call rand() wantedDigits times and use the least significant digit each time
+Unsigned Unsigned::random(const Unsigned &wantedDigits) {
+	static bool bRandInitialized = false;
+
+	if (!bRandInitialized) {
+		bRandInitialized = true;
+		srand((unsigned int)time(NULL));
+	}
+
+	const long n = wantedDigits.toLong();
+	if (n <= 0) return 0;
+
+	std::string digits;
+	for (long i = 0; i < n; i++) {
+		const int r = rand();
+		const int digit = r % 10;
+		digits += intToChar(digit);
+	}
+
+	return Unsigned(digits.c_str());
+}
+
+// Primes below SIEVE_BASE_LIMIT, sieved once and kept: the trial divisors for isPrime()
+// and the sieving primes for ranges.
+static const limb_t SIEVE_BASE_LIMIT = (limb_t)1 << 20;
+
+static const std::vector<limb_t> &sievePrimes() {
+	static std::vector<limb_t> primes;
+	static std::once_flag once;
+
+	std::call_once(once, []() {
+		std::vector<bool> composite(SIEVE_BASE_LIMIT, false);
+		for (limb_t p = 2; p < SIEVE_BASE_LIMIT; p++) {
+			if (composite[p]) continue;
+			primes.push_back(p);
+			for (dlimb_t multiple = (dlimb_t)p * p; multiple < SIEVE_BASE_LIMIT; multiple += p) {
+				composite[(size_t)multiple] = true;
+			}
+		}
+	});
+	return primes;
+}
+
+// Primes below SMALL_PRIME_LIMIT grouped so each group's product fits in a limb:
+// one modSmall() by the product tests the whole group.
+static const limb_t SMALL_PRIME_LIMIT = 1000;
+
+class SmallPrimes {
+public:
+	std::vector<limb_t> primes;
+	std::vector<size_t> groupEnds;	// Group i is primes[groupEnds[i - 1]] up to primes[groupEnds[i]]
+	std::vector<limb_t> products;
+
+	SmallPrimes() {
+		const std::vector<limb_t> &all = sievePrimes();
+		primes.assign(all.begin(), std::lower_bound(all.begin(), all.end(), SMALL_PRIME_LIMIT));
+
+		dlimb_t product = 1;
+		for (size_t i = 0; i < primes.size(); i++) {
+			if (product * primes[i] > (limb_t)~0) {
+				groupEnds.push_back(i);
+				products.push_back((limb_t)product);
+				product = 1;
+			}
+			product *= primes[i];
+		}
+		groupEnds.push_back(primes.size());
+		products.push_back((limb_t)product);
+	}
+};
+
+static const SmallPrimes &smallPrimes() {
+	static const SmallPrimes primes;
+	return primes;
+}
+
+// Jacobi symbol (a / m) for odd m
+static int jacobiSmall(unsigned long long a, unsigned long long m) {
+	int result = 1;
+	a %= m;
+	while (a != 0) {
+		while ((a & 1) == 0) {
+			a /= 2;
+			if (m % 8 == 3 || m % 8 == 5) result = -result;
+		}
+		std::swap(a, m);
+		if (a % 4 == 3 && m % 4 == 3) result = -result;
+		a %= m;
+	}
+	return m == 1 ? result : 0;
+}
+
+// Jacobi symbol (d / n) for odd n, with quadratic reciprocity to get down to native integers
+int Unsigned::jacobi(long d, const Unsigned &n) {
+	int result = 1;
+	const limb_t nMod8 = n.isZero() ? 0 : n.mLimbs[0] % 8;
+
+	if (d < 0) {
+		d = -d;
+		if (nMod8 % 4 == 3) result = -result;
+	}
+	while (d != 0 && d % 2 == 0) {
+		d /= 2;
+		if (nMod8 == 3 || nMod8 == 5) result = -result;
+	}
+	if (d % 4 == 3 && nMod8 % 4 == 3) result = -result;
+
+	return result * jacobiSmall(modSmall(n, (limb_t)d), (unsigned long long)d);
+}
+
+// base^exp mod m by Montgomery multiplication.  An even m is put together from its odd part
+// and its power of two.
+Unsigned Unsigned::powMod(const Unsigned &base, const Unsigned &exp, const Unsigned &m) {
+	if (m.isZero() || m.isOne()) return mod(gUnsignedZero, m);
+	if (m.isOdd()) return Montgomery(m).powMod(base, exp);
+
+	// m = 2^k q, q odd.  Mod 2^k is just the low k bits.
+	size_t k = 0;
+	while (!m.testBit(k)) {
+		k++;
+	}
+	Unsigned q(m);
+	q.shiftRight(k);
+
+	const Unsigned low = slidingWindowPower(gUnsignedOne, lowBits(base, k), exp,
+		[k](const Unsigned &x) { return lowBits(square(x), k); },
+		[k](const Unsigned &x, const Unsigned &y) { return lowBits(multiply(x, y), k); });
+	if (q.isOne()) return low;
+
+	// The Chinese remainder theorem: high + q h is high mod q and low mod 2^k for
+	// h = (low - high) / q mod 2^k
+	const Unsigned high = Montgomery(q).powMod(base, exp);
+	Unsigned twoToK;
+	twoToK.setBit(k);
+	const Unsigned h = lowBits((low + twoToK - lowBits(high, k)) * inversePowerOfTwo(q, k), k);
+	return high + q * h;
+}
+
+// Strong probable prime to base for odd n > 3: with n - 1 = d 2^s, d odd,
+// base^d = 1 or base^(d 2^r) = -1 for some r < s
+bool Unsigned::isStrongProbablePrime(const Unsigned &n, const Unsigned &base) {
+	const Unsigned nMinusOne = n - gUnsignedOne;
+	size_t s = 0;
+	while (!nMinusOne.testBit(s)) {
+		s++;
+	}
+	Unsigned d(nMinusOne);
+	d.shiftRight(s);
+
+	Unsigned x = powMod(base, d, n);
+	if (x.isOne() || x == nMinusOne) return true;
+
+	for (size_t r = 1; r < s; r++) {
+		x = mod(square(x), n);
+		if (x == nMinusOne) return true;
+		if (x.isOne()) return false;
+	}
+	return false;
+}
+
+// x / 2 mod odd n for x < 2n
+static Unsigned halfMod(Unsigned x, const Unsigned &n) {
+	if (x >= n) {
+		x.subtract(n);
+	}
+	if (x.isOdd()) {
+		x.add(n);
+	}
+	return Unsigned::half(x);
+}
+
+// Strong Lucas probable prime for odd n, not a square, with Selfridge's parameters:
+// the first D of 5, -7, 9, -11, ... with (D / n) = -1, P = 1 and Q = (1 - D) / 4.
+// With n + 1 = k 2^s, k odd, U(k) = 0 or V(k 2^r) = 0 for some r < s.
+// U and V go up through the bits of k: U(2j) = U(j) V(j), V(2j) = V(j)^2 - 2 Q^j,
+// U(j + 1) = (U(j) + V(j)) / 2, V(j + 1) = (D U(j) + V(j)) / 2.
+bool Unsigned::isStrongLucasProbablePrime(const Unsigned &n) {
+	long d = 5;
+	for (;;) {
+		const int j = jacobi(d, n);
+		if (j == -1) break;
+		if (j == 0 && n > Unsigned((long long)(d < 0 ? -d : d))) return false;	// |d| is a factor
+		d = d > 0 ? -(d + 2) : -d + 2;
+	}
+	const long q = (1 - d) / 4;
+
+	// D and Q as residues mod n
+	Unsigned dMod((long long)(d < 0 ? -d : d));
+	if (d < 0) dMod = n - dMod;
+	Unsigned qMod((long long)(q < 0 ? -q : q));
+	if (q < 0) qMod = n - qMod;
+
+	const Unsigned nPlusOne = n + gUnsignedOne;
+	size_t s = 0;
+	while (!nPlusOne.testBit(s)) {
+		s++;
+	}
+	Unsigned k(nPlusOne);
+	k.shiftRight(s);
+
+	Unsigned u(1), v(1), qk(qMod);
+	for (size_t bit = k.bitLength() - 1; bit-- > 0;) {
+		u = mod(u * v, n);
+		v = mod(square(v) + shifted(n - qk, 1), n);
+		qk = mod(square(qk), n);
+		if (k.testBit(bit)) {
+			const Unsigned newU = halfMod(u + v, n);
+			v = halfMod(mod(dMod * u, n) + v, n);
+			u = newU;
+			qk = mod(qk * qMod, n);
+		}
+	}
+
+	if (u.isZero() || v.isZero()) return true;
+
+	for (size_t r = 1; r < s; r++) {
+		v = mod(square(v) + shifted(n - qk, 1), n);
+		qk = mod(square(qk), n);
+		if (v.isZero()) return true;
+	}
+	return false;
+}
+
+// Baillie-PSW: trial division by the small primes, a strong probable prime test to base 2,
+// then a strong Lucas test.  No composite is known to pass both.
+Unsigned Unsigned::isPrime(const Unsigned &a) {
+	if (a <= 1) return false;
+
+	const SmallPrimes &small = smallPrimes();
+	size_t start = 0;
+	for (size_t group = 0; group < small.products.size(); group++) {
+		const limb_t rem = modSmall(a, small.products[group]);
+		for (size_t i = start; i < small.groupEnds[group]; i++) {
+			if (rem % small.primes[i] == 0) {
+				return a.length() == 1 && a.mLimbs[0] == small.primes[i];
+			}
+		}
+		start = small.groupEnds[group];
 	}
 
-	workingA.trim();
-}
+	// No factor below SMALL_PRIME_LIMIT
+	if (a.length() == 1 && a.mLimbs[0] < SMALL_PRIME_LIMIT * SMALL_PRIME_LIMIT) return true;
 
-Unsigned Unsigned::subtract(const Unsigned &a, const Unsigned &b) {
-	Unsigned workingA(a);
-	Unsigned workingB(b);
+	if (!isStrongProbablePrime(a, gUnsignedTwo)) return false;
 
-	subtractMutable(workingA, workingB);
+	if (isPerfectSquare(a)) return false;
 
-	return workingA;
+	return isStrongLucasProbablePrime(a);
 }
 
-Unsigned Unsigned::multiply(const Unsigned &a, const Unsigned &b) {
-	Unsigned	sum(0);
-	Unsigned	partProduct;
+// isPrime() and then strong probable prime tests to rounds random bases
+Unsigned Unsigned::isProbablePrime(const Unsigned &a, const int rounds) {
+	if (!isPrime(a).isOne()) return false;
+	if (a.length() == 1 && a.mLimbs[0] < SMALL_PRIME_LIMIT * SMALL_PRIME_LIMIT) return true;
+
+	// Bases from 2 to a - 2
+	const Unsigned baseRange = a - Unsigned(3);
+	const Unsigned digits((long long)(a.bitLength() * 30103 / 100000 + 1));
+	for (int i = 0; i < rounds; i++) {
+		const Unsigned base = mod(random(digits), baseRange) + gUnsignedTwo;
+		if (!isStrongProbablePrime(a, base)) return false;
+	}
+	return true;
+}
 
-	partProduct.pad(a.length() + b.length());
-	for (int i = 0; i < (int)b.length(); i++) {
-		const int bIndex = (int)b.length() - 1 - i;
-		const int bDigit = b.mDigits[bIndex];
+// Segmented sieve
+//
+// A range is cut into SIEVE_SEGMENT number segments, sieved on their own and in parallel by
+// the primes up to sqrt(end).  Below SIEVE_BASE_LIMIT^2 that is complete; above it the
+// numbers left over have no factor below SIEVE_BASE_LIMIT and are checked with isPrime().
+static const size_t SIEVE_SEGMENT = (size_t)1 << 16;
+
+// prime[i] = whether start + i has no factor up to sqrt(end) or SIEVE_BASE_LIMIT, for i < length.
+// Returns whether that makes them prime.
+bool Unsigned::sieveSegment(const Unsigned &start, const size_t length, std::vector<char> &prime) {
+	prime.assign(length, 1);
+	const Unsigned end = start + Unsigned((long long)length);
+	const bool native = end.length() <= 2;
+	const uint64_t nativeStart = native ? start.toULongLong() : 0;
+
+	// 0 and 1 aren't prime
+	for (uint64_t i = nativeStart; native && i < 2 && i < nativeStart + length; i++) {
+		prime[(size_t)(i - nativeStart)] = 0;
+	}
 
-		int carry = 0;
-		partProduct.zero();
-		int j = 0;
-		for (; j < (int)a.length(); j++) {
-			const int aIndex = (int)a.length() -1 - j;
-			const int aDigit = a.mDigits[aIndex];
-			const int digit = bDigit * aDigit + carry;
-			const int ppIndex = (int)partProduct.length() -1 - j - i;
-			partProduct.mDigits[ppIndex] = digit % 10;
-			carry = digit / 10;
+	const uint64_t bound = native ? sqrt64(end.toULongLong()) : SIEVE_BASE_LIMIT;
+	const std::vector<limb_t> &primes = sievePrimes();
+	for (size_t i = 0; i < primes.size() && primes[i] <= bound; i++) {
+		const uint64_t p = primes[i];
+		uint64_t first;
+		if (native && nativeStart <= p * p) {
+			first = p * p - nativeStart;	// Smaller multiples have smaller factors, and p stays prime
 		}
-
-		for(; carry > 0; j++) {
-			const int ppIndex = (int)partProduct.length() -1 - j - i;
-			partProduct.mDigits[ppIndex] = carry % 10;
-			carry /= 10;
+		else {
+			first = (p - (native ? nativeStart % p : modSmall(start, (limb_t)p))) % p;
+		}
+		for (uint64_t j = first; j < length; j += p) {
+			prime[(size_t)j] = 0;
 		}
-
-		sum.add(partProduct);
 	}
 
-	sum.trim();
-	return sum;
+	return bound < SIEVE_BASE_LIMIT;
 }
 
-UnsignedDivide Unsigned::divideByOneWithRem(const Unsigned &dividend) {
-	UnsignedDivide result(dividend, 0);
-	return result;
+// The number of segments in [lo, hi), 0 for an empty range or one of 2^32 numbers or more
+static size_t sieveSegments(const Unsigned &lo, const Unsigned &hi) {
+	if (hi <= lo || hi - lo > Unsigned((long long)0xFFFFFFFF)) return 0;
+	return (size_t)(((hi - lo).toULongLong() + SIEVE_SEGMENT - 1) / SIEVE_SEGMENT);
 }
 
-// https://en.wikipedia.org/wiki/Division_by_two
-UnsignedDivide Unsigned::divideByTwoWithRem(const Unsigned &dividend) {
-	Unsigned working(dividend);
-	UnsignedDivide result;
-
-	working.prepend(0);
-
-	const int len1 = (int)working.length() - 1;
-	int first = 0, second = 0;
-	for (int i = 0; i < len1; i++) {
-		first = working.mDigits[i];
-		second = working.mDigits[i + 1];
-		int save = 0;
-		if (::isEven(first)) {
-			switch(second) {
-		 case 0:
-		 case 1:
-			 save = 0;
-			 break;
-		 case 2:
-		 case 3:
-			 save = 1;
-			 break;
-		 case 4:
-		 case 5:
-			 save = 2;
-			 break;
-		 case 6:
-		 case 7:
-			 save = 3;
-			 break;
-		 case 8:
-		 case 9:
-			 save = 4;
-			 break;
+// Sieves [lo, hi) one segment per task, calling visit(segment, start, prime) from the task
+template <typename Visit>
+void Unsigned::sieveRange(const Unsigned &lo, const Unsigned &hi, const Visit &visit) {
+	const size_t n = sieveSegments(lo, hi) == 0 ? 0 : (size_t)(hi - lo).toULongLong();
+
+	parallelFor(sieveSegments(lo, hi), [&](const size_t segment) {
+		const size_t offset = segment * SIEVE_SEGMENT;
+		const size_t length = std::min(n - offset, SIEVE_SEGMENT);
+		const Unsigned start = lo + Unsigned((long long)offset);
+
+		std::vector<char> prime;
+		if (!sieveSegment(start, length, prime)) {
+			for (size_t i = 0; i < length; i++) {
+				if (prime[i] && !isPrime(start + Unsigned((long long)i)).isOne()) {
+					prime[i] = 0;
+				}
 			}
 		}
-		else {
-			switch(second) {
-		 case 0:
-		 case 1:
-			 save = 5;
-			 break;
-		 case 2:
-		 case 3:
-			 save = 6;
-			 break;
-		 case 4:
-		 case 5:
-			 save = 7;
-			 break;
-		 case 6:
-		 case 7:
-			 save = 8;
-			 break;
-		 case 8:
-		 case 9:
-			 save = 9;
-			 break;
+		visit(segment, start, prime);
+	});
+}
+
+std::vector<Unsigned> Unsigned::primes(const Unsigned &lo, const Unsigned &hi) {
+	std::vector<std::vector<Unsigned> > found(sieveSegments(lo, hi));
+
+	sieveRange(lo, hi, [&](const size_t segment, const Unsigned &start, const std::vector<char> &prime) {
+		for (size_t i = 0; i < prime.size(); i++) {
+			if (prime[i]) {
+				found[segment].push_back(start + Unsigned((long long)i));
 			}
 		}
-		result.quotient.append(save);
-	}
+	});
 
-	if (::isOdd(second)) {
-		result.remainder = 1;
+	std::vector<Unsigned> result;
+	for (size_t segment = 0; segment < found.size(); segment++) {
+		result.insert(result.end(), found[segment].begin(), found[segment].end());
 	}
+	return result;
+}
 
-	result.trim();
+Unsigned Unsigned::countPrimes(const Unsigned &lo, const Unsigned &hi) {
+	std::atomic<unsigned long long> count(0);
+
+	sieveRange(lo, hi, [&](const size_t, const Unsigned &, const std::vector<char> &prime) {
+		count += (unsigned long long)std::count(prime.begin(), prime.end(), 1);
+	});
+
+	Unsigned result;
+	result.setULongLong(count);
 	return result;
 }
 
-// Division by repeated subtraction
-UnsignedDivide Unsigned::divideWithRemSlow(const Unsigned &dividend, const Unsigned &divisor) {
-	UnsignedDivide result(0, dividend);
+Unsigned Unsigned::nextPrime(const Unsigned &n) {
+	Unsigned start = n + gUnsignedOne;
+	const Unsigned step((long long)SIEVE_SEGMENT);
+	std::vector<char> prime;
+
+	for (;;) {
+		const bool complete = sieveSegment(start, SIEVE_SEGMENT, prime);
+		for (size_t i = 0; i < prime.size(); i++) {
+			if (!prime[i]) continue;
 
-	if (divisor <= gUnsignedTwo) {
-		switch(divisor.toInt()) {
-	  case 0:
-		  fprintf(stderr, "Division by zero\n");
-		  result.quotient.mkError();
-		  return result;
-	  case 1:
-		  return divideByOneWithRem(dividend);
-	  case 2:
-		  return divideByTwoWithRem(dividend);
+			const Unsigned candidate = start + Unsigned((long long)i);
+			if (complete || isPrime(candidate).isOne()) return candidate;
 		}
+		addMutable(start, step);
 	}
+}
 
-	while (result.remainder >= divisor) {
-		result.quotient++;
-		result.remainder.subtract(divisor);
+// x^e mod m for m < 2^32
+static unsigned long long powModNative(unsigned long long x, limb_t e, const unsigned long long m) {
+	unsigned long long result = 1;
+	for (x %= m; e > 0; e >>= 1) {
+		if (e & 1) result = result * x % m;
+		x = x * x % m;
 	}
-
-	result.trim();
 	return result;
 }
 
-// Helper for divideWithRemFast()
-Unsigned Unsigned::findDivisibleSizedChunk(const Unsigned &runningDividend, const Unsigned &dividend, const Unsigned &divisor, int &iDividendPos, bool &fits) {
-	Unsigned chunk;
-	iDividendPos = 0;
-	for (; iDividendPos < (int)dividend.length(); iDividendPos++) {
-		int digit;
-		if (runningDividend.mDigits[iDividendPos] >= 0) {
-			digit = runningDividend.mDigits[iDividendPos];
-		}
-		else {
-			digit = dividend.mDigits[iDividendPos];
-		}
+// Whether a might be a k-th power, for prime k: a k-th power is 0 or a k-th power residue mod
+// every prime p = 1 mod k, a^((p - 1) / k) = 1, which a random number is only 1 time in k.
+// Tries enough such p below SIEVE_BASE_LIMIT to leave about a one in a million chance.
+static bool mightBePower(const Unsigned &a, const limb_t k) {
+	const std::vector<limb_t> &primes = sievePrimes();
+	int wanted = 1;
+	for (limb_t chance = k; chance < 1000000; chance *= k) {
+		wanted++;
+	}
 
-		chunk.append(digit);
+	for (dlimb_t p = 2 * (dlimb_t)k + 1; p < SIEVE_BASE_LIMIT && wanted > 0; p += 2 * k) {
+		if (!std::binary_search(primes.begin(), primes.end(), (limb_t)p)) continue;
 
-		if (chunk >= divisor) {
-			fits = true;
-			return chunk;
-		}
+		const limb_t r = Unsigned::modSmall(a, (limb_t)p);
+		if (r != 0 && powModNative(r, (limb_t)((p - 1) / k), p) != 1) return false;
+		wanted--;
 	}
-
-	fits = false;
-	return chunk;
+	return true;
 }
 
-// https://en.wikipedia.org/wiki/Long_division#Example_with_multi-digit_divisor
-UnsignedDivide Unsigned::divideWithRemFast(const Unsigned &dividend, const Unsigned &divisor) {
-	Unsigned runningDividend;
-	UnsignedDivide	result;
-
-	result.quotient.pad(dividend.length());
-	runningDividend.appendRight(UNASSIGNED, dividend.length());
+// a = b^k for some b and k >= 2, or odd k >= 3 when oddOnly is set.  Only prime k need
+// trying, and with a = 2^t odd, only k dividing t.  A root of up to 32 bits is within one of
+// what doubles make of it, so those k only cost a check mod a prime; for the rest
+// mightBePower() rules out nearly every k before a root gets worked out.
+bool Unsigned::isPerfectPower(const Unsigned &a, const bool oddOnly) {
+	if (a.length() <= 1 && a.toULongLong() <= 1) return true;
 
-	if (divisor <= gUnsignedTwo) {
-		switch(divisor.toInt()) {
-	  case 0:
-		  fprintf(stderr, "Division by zero\n");
-		  result.quotient.mkError();
-		  return result;
-	  case 1:
-		  return divideByOneWithRem(dividend);
-	  case 2:
-		  return divideByTwoWithRem(dividend);
-		}
+	size_t twos = 0;
+	while (!a.testBit(twos)) {
+		twos++;
 	}
 
-	int iDividendPos = 0;
-	bool fits;
-	for (;;) {
-		const Unsigned chunk = findDivisibleSizedChunk(runningDividend, dividend, divisor, iDividendPos, fits);
-		if (!fits) {
-			result.remainder = chunk;
-			break;
-		}
+	const size_t bits = a.bitLength();
+	const size_t shift = bits > 64 ? bits - 64 : 0;
+	Unsigned top(a);
+	top.shiftRight(shift);
+	const double log2a = ::log2((double)top.toULongLong()) + (double)shift;
 
-		const UnsignedDivide partDivide = divideWithRemSlow(chunk, divisor);
-		const Unsigned partProd = subtract(chunk, partDivide.remainder);
-		result.quotient[iDividendPos] = partDivide.quotient.mDigits[0];
+	const unsigned long long check = 4294967291ULL;
+	const unsigned long long aModCheck = modSmall(a, (limb_t)check);
 
-		runningDividend = subtract(chunk, partProd);
-		runningDividend.appendRight(UNASSIGNED, dividend.length() - iDividendPos - 1);
-		runningDividend.pad(dividend.length()); 
-	}
+	const std::vector<limb_t> &primes = sievePrimes();
+	for (size_t i = 0; i < primes.size() && primes[i] < bits; i++) {
+		const limb_t k = primes[i];
+		if ((twos > 0 && twos % k != 0) || (oddOnly && k == 2)) continue;
 
-	result.trim();
-	return result;
+		if (k == 2) {
+			if (isPerfectSquare(a)) return true;
+		}
+		else if ((bits + k - 1) / k <= 32) {
+			const unsigned long long estimate = (unsigned long long)::llround(::exp2(log2a / k));
+			for (unsigned long long r = estimate > 1 ? estimate - 1 : 1; r <= estimate + 1; r++) {
+				if (powModNative(r, k, check) == aModCheck
+					&& pow(Unsigned((long long)r), Unsigned((long long)k)) == a) return true;
+			}
+		}
+		else if (mightBePower(a, k) && pow(root(a, k), Unsigned((long long)k)) == a) {
+			return true;
+		}
+	}
+	return false;
 }
 
-Unsigned Unsigned::divide(const Unsigned &a, const Unsigned &b) {
-	return divideWithRemFast(a, b).quotient;
+// Factorials
+//
+// n! is built from its prime factorization instead of n - 1 multiplies: p divides n! to
+// the power sum(n / p^i) (Legendre), so n! = 2^e * prod over bits k of (product of the odd
+// primes whose exponent has bit k set)^(2^k).  That is a few balanced product trees of
+// distinct primes joined by squarings, going down from the top bit.
+static const size_t PRODUCT_LEAF = 32;	// Factors multiplied one limb at a time
+static const size_t PRODUCT_PARALLEL = 4096;	// Factors worth splitting over two threads
+
+// The exponent of prime p in n!
+static limb_t legendre(const limb_t n, const limb_t p) {
+	limb_t exponent = 0;
+	for (limb_t q = n / p; q > 0; q /= p) {
+		exponent += q;
+	}
+	return exponent;
 }
 
-Unsigned Unsigned::half(const Unsigned &a) {
-	return divideByTwoWithRem(a).quotient;
-}
+// The primes up to n
+static void primesUpTo(const limb_t n, std::vector<limb_t> &result) {
+	const std::vector<limb_t> &base = sievePrimes();
+	if (n < SIEVE_BASE_LIMIT) {
+		result.assign(base.begin(), std::upper_bound(base.begin(), base.end(), n));
+		return;
+	}
 
-Unsigned Unsigned::mod(const Unsigned &a, const Unsigned &b) {
-	return divideWithRemFast(a, b).remainder;
+	result = base;
+	const std::vector<Unsigned> more = Unsigned::primes(Unsigned((long long)SIEVE_BASE_LIMIT), Unsigned((long long)n + 1));
+	for (size_t i = 0; i < more.size(); i++) {
+		result.push_back((limb_t)more[i].toULongLong());
+	}
 }
 
-Unsigned Unsigned::pow(const Unsigned &a, const Unsigned &n) {
-	if (n.isZero()) return gUnsignedOne;
-
-	const Unsigned x = pow(a, half(n));
+// factors[begin] * ... * factors[end - 1], as a balanced tree
+Unsigned Unsigned::product(const std::vector<limb_t> &factors, const size_t begin, const size_t end) {
+	if (end - begin <= PRODUCT_LEAF) {
+		Unsigned result(1);
+		dlimb_t packed = 1;
+		for (size_t i = begin; i < end; i++) {
+			if (packed * factors[i] > (limb_t)~0) {
+				result.multiplyAddSmall((limb_t)packed, 0);
+				packed = 1;
+			}
+			packed *= factors[i];
+		}
+		result.multiplyAddSmall((limb_t)packed, 0);
+		return result;
+	}
 
-	if (n.isEven()) {
-		return x * x;
+	const size_t mid = begin + (end - begin) / 2;
+	Unsigned halves[2];
+	const auto half = [&](const size_t i) {
+		halves[i] = i == 0 ? product(factors, begin, mid) : product(factors, mid, end);
+	};
+	if (end - begin >= PRODUCT_PARALLEL) {
+		parallelFor(2, half);
 	}
 	else {
-		return a * x * x;
+		half(0);
+		half(1);
 	}
+	return multiply(halves[0], halves[1]);
 }
 
-// Euler's method
-Unsigned Unsigned::gcd(const Unsigned &a, const Unsigned &b) {
-	if (a.isZero()) return b;
-	return gcd(b % a, a);
-}
-
-// Newton's method
-Unsigned Unsigned::sqrt(const Unsigned &s) {
-	Unsigned x0 = half(s);
-
-	if (x0.isZero()) return s;
+// prod primes[i]^exponents[i]
+Unsigned Unsigned::primePowerProduct(const std::vector<limb_t> &primes, const std::vector<limb_t> &exponents) {
+	size_t twos = 0;
+	limb_t allBits = 0;
+	for (size_t i = 0; i < primes.size(); i++) {
+		if (primes[i] == 2) {
+			twos = exponents[i];
+		}
+		else {
+			allBits |= exponents[i];
+		}
+	}
 
-	Unsigned x1 = half(x0 + s / x0);
+	Unsigned result(1);
+	std::vector<limb_t> factors;
+	for (int bit = LIMB_BITS - 1; bit >= 0; bit--) {
+		if (!result.isOne()) {
+			result = square(result);
+		}
+		if ((allBits >> bit & 1) == 0) continue;
 
-	while(x1 < x0) {
-		x0 = x1;
-		x1 = half(x0 + s / x0);
+		factors.clear();
+		for (size_t i = 0; i < primes.size(); i++) {
+			if (primes[i] != 2 && (exponents[i] >> bit & 1) != 0) {
+				factors.push_back(primes[i]);
+			}
+		}
+		result = multiply(result, product(factors, 0, factors.size()));
 	}
 
-	return x0;
+	result.shiftLeft(twos);
+	return result;
 }
 
-// Call rand() wantedDigits times and use the least significant digit each time
-Unsigned Unsigned::random(const Unsigned &wantedDigits) {
-	static bool bRandInitialized = false;
+Unsigned Unsigned::factorial(const limb_t n) {
+	return factorialRatio(n, 0);
+}
 
-	if (!bRandInitialized) {
-		bRandInitialized = true;
-		srand((unsigned int)time(NULL));
-	}
+// n!! = n (n - 2) (n - 4) ...
+Unsigned Unsigned::doubleFactorial(const limb_t n) {
+	// (2m)!! = 2^m m!
+	if (n % 2 == 0) return shifted(factorial(n / 2), n / 2);
 
-	Unsigned result;
-	const long n = wantedDigits.toLong();
-	if (n <= 0) return 0;
-	for (long i = 0; i < n; i++) {
-		const int r = rand();
-		const int digit = r % 10;
-		result.append(digit);
+	// n! = n!! (n - 1)!! = n!! 2^m m! for n = 2m + 1, so the odd primes' exponents are a difference
+	std::vector<limb_t> primes, exponents;
+	primesUpTo(n, primes);
+	for (size_t i = 0; i < primes.size(); i++) {
+		exponents.push_back(primes[i] == 2 ? 0 : legendre(n, primes[i]) - legendre(n / 2, primes[i]));
 	}
-
-	return result;
+	return primePowerProduct(primes, exponents);
 }
 
-// By Soma Mbadiwe on https://stackoverflow.com/questions/15743192/check-if-number-is-prime-number
-Unsigned Unsigned::isPrime(const Unsigned &a) {
-	if (a <= 1) return false;
-	if (a == 2 || a == 3 || a == 5) return true;
-	if (a.isEven() || a % 3 == 0 || a % 5 == 0) return false;
+// n! / k! = (k + 1) (k + 2) ... n for k <= n
+Unsigned Unsigned::factorialRatio(const limb_t n, const limb_t k) {
+	if (k >= n) return gUnsignedOne;
 
-	const Unsigned boundary = sqrt(a);
-	for (Unsigned i = 6; i <= boundary; i += 6) {
-		if (a % (i + 1) == 0 || a % (i + 5) == 0) {
-			return false;
+	// A short run is cheaper multiplied out than through the primes up to n
+	if (n - k <= n / 8) {
+		std::vector<limb_t> factors;
+		for (limb_t i = k + 1; i != n + 1; i++) {
+			factors.push_back(i);
 		}
+		return product(factors, 0, factors.size());
 	}
 
-	return true;
+	std::vector<limb_t> primes, exponents;
+	primesUpTo(n, primes);
+	for (size_t i = 0; i < primes.size(); i++) {
+		exponents.push_back(legendre(n, primes[i]) - legendre(k, primes[i]));
+	}
+	return primePowerProduct(primes, exponents);
 }
 
 void Unsigned::add(const Unsigned &other) {
-	Unsigned workingB(other);
-
-	addMutable(*this, workingB);
+	addMutable(*this, other);
 }
 
 void Unsigned::subtract(const Unsigned &other) {
-	Unsigned workingB(other);
-
-	subtractMutable(*this, workingB);
+	subtractMutable(*this, other);
 }
 
 void Unsigned::multiply(const Unsigned &other) {
@@ -630,16 +3842,13 @@ void Unsigned::pow(const Unsigned &other) {
 	set(pow(*this, other));
 }
 
-int Unsigned::compare(const Unsigned &aIn, const Unsigned &bIn) {
-	const Unsigned *pA = &aIn;
-	const Unsigned *pB = &bIn;
-	Unsigned padded;
-
-	padShorterNumber(pA, pB, padded);
+int Unsigned::compare(const Unsigned &a, const Unsigned &b) {
+	if (a.length() < b.length()) return -1;
+	if (a.length() > b.length()) return 1;
 
-	for (size_t i = 0; i < pA->length(); i++) {
-		if (pA->mDigits[i] < pB->mDigits[i]) return -1;
-		if (pA->mDigits[i] > pB->mDigits[i]) return 1;
+	for (size_t i = a.length(); i-- > 0;) {
+		if (a.mLimbs[i] < b.mLimbs[i]) return -1;
+		if (a.mLimbs[i] > b.mLimbs[i]) return 1;
 	}
 
 	return 0;
@@ -671,59 +3880,59 @@ void ArbNum::set(const ArbNum &in) {
 	mUnsigned = in.mUnsigned;
 }
 
+void ArbNum::set(ArbNum &&in) {
+	mSpecial = in.mSpecial;
+	mSign = in.mSign;
+	mUnsigned = std::move(in.mUnsigned);
+}
+
 ArbNum::ArbNum(const Unsigned &in) {
 	clear();
 	mUnsigned = in;
 }
 
+ArbNum::ArbNum(Unsigned &&in) : mSpecial(SPEC_NORMAL), mSign(1), mUnsigned(std::move(in)) {
+}
+
 ArbNum::ArbNum(const ArbNum &in) {
 	set(in);
 }
 
+ArbNum::ArbNum(ArbNum &&in) noexcept : mSpecial(in.mSpecial), mSign(in.mSign), mUnsigned(std::move(in.mUnsigned)) {
+}
+
 ArbNum::ArbNum(const char *s) {
 	saveNumber(s);
 }
 
 ArbNum::ArbNum(const int n) {
-	char	buf[100];
-
-#ifdef __BORLANDC__
-	sprintf(buf, "%d", n);
-#else
-	snprintf(buf, sizeof(buf), "%d", n);
-#endif
-
-	saveNumber(buf);
+	setLongLong(n);
 }
 
 ArbNum::ArbNum(const long n) {
-	char	buf[100];
-
-#ifdef __BORLANDC__
-	sprintf(buf, "%ld", n);
-#else
-	snprintf(buf, sizeof(buf), "%ld", n);
-#endif
-
-	saveNumber(buf);
+	setLongLong(n);
 }
 
 ArbNum::ArbNum(const long long n) {
-	char	buf[100];
-
-#ifdef __BORLANDC__
-	sprintf(buf, "%lld", n);
-#else
-	snprintf(buf, sizeof(buf), "%lld", n);
-#endif
-
-	saveNumber(buf);
+	setLongLong(n);
 }
 
 ArbNum::ArbNum(const bool b) {
 	set((int) b);
 }
 
+void ArbNum::setLongLong(const long long n) {
+	clear();
+
+	if (n < 0) {
+		mkNegative();
+		mUnsigned.setULongLong(0ULL - (unsigned long long)n);	// Also works for LLONG_MIN
+	}
+	else {
+		mUnsigned.setULongLong(n);
+	}
+}
+
 void ArbNum::clear() {
 	mSpecial = SPEC_NORMAL;
 	mkPositive();
@@ -750,71 +3959,14 @@ ArbNum ArbNum::sign(const ArbNum &a) {
 }
 
 ArbNum ArbNum::add(const ArbNum &a, const ArbNum &b) {
-	ArbNum result;
-	if (a.isPositiveOrZero() && b.isPositiveOrZero()) {
-		// Both positive => will stay positive
-		result.mUnsigned = Unsigned::add(a.mUnsigned, b.mUnsigned);
-	}
-	else if (a.isPositiveOrZero() && b.isNegativeOrZero()) {
-		// Remove sign from other, subtract other from this
-		ArbNum workingB(b);
-		workingB.mkPositive();
-		result = ArbNum::subtract(a, workingB);  // Need to use ArbNum::subtract() because it checks to see which larger
-	}
-	else if (a.isNegativeOrZero() && b.isPositiveOrZero()) {
-		// -a + b = b - a
-		ArbNum workingA(a);
-		workingA.mkPositive();
-		result = ArbNum::subtract(b, workingA); // Need to use ArbNum::subtract() because it checks to see which larger
-	}
-	else if (a.isNegativeOrZero() && b.isNegativeOrZero()) {
-		// Both negative => will stay negative
-		result.mkNegative();
-		result.mUnsigned = Unsigned::add(a.mUnsigned, b.mUnsigned);
-
-	}
-	else {
-		fprintf(stderr, "add: unknown case\n");
-		result.mkError();
-	}
+	ArbNum result(a);
+	result.add(b);
 	return result;
 }
 
 ArbNum ArbNum::subtract(const ArbNum &a, const ArbNum &b) {
-	ArbNum result;
-	if (a.isPositiveOrZero() && b.isPositiveOrZero()) {
-		if (a.mUnsigned < b.mUnsigned) {
-			// a - b = - (b - a)
-			result.mkNegative();
-			result.mUnsigned = Unsigned::subtract(b.mUnsigned, a.mUnsigned);
-		}
-		else {
-			// Easy a - b
-			result.mUnsigned = Unsigned::subtract(a.mUnsigned, b.mUnsigned);
-		}
-	}
-	else if (a.isPositiveOrZero() && b.isNegativeOrZero()) {
-		// a - (-b) = a + b
-		// Sign is already positive
-		result.mUnsigned = Unsigned::add(a.mUnsigned, b.mUnsigned);
-	}
-	else if (a.isNegativeOrZero() && b.isPositiveOrZero()) {
-		// (-a) - b = - (a + b)
-		result.mkNegative();
-		result.mUnsigned = Unsigned::add(a.mUnsigned, b.mUnsigned);
-	}
-	else if (a.isNegativeOrZero() && b.isNegativeOrZero()) {
-		// (-a) - (-b) = b - a
-		ArbNum workingA(a);
-		ArbNum workingB(b);
-		workingA.mkPositive();
-		workingB.mkPositive();
-		result = ArbNum::subtract(workingB, workingA);	// Recursive
-	}
-	else{
-		fprintf(stderr, "subtract: unknown case\n");
-		result.mkError();
-	}
+	ArbNum result(a);
+	result.subtract(b);
 	return result;
 }
 
@@ -825,6 +3977,17 @@ ArbNum ArbNum::multiply(const ArbNum &a, const ArbNum &b) {
 	return result;
 }
 
+// mod(a * b, m) with the product reduced in place instead of going through divideWithRem()
+ArbNum ArbNum::multiplyMod(const ArbNum &a, const ArbNum &b, const ArbNum &m) {
+	if (m.isZero()) return mod(multiply(a, b), m);
+
+	ArbNum result = Unsigned::mod(Unsigned::multiply(a.mUnsigned, b.mUnsigned), m.mUnsigned);
+	if (a.mSign * b.mSign < 0 && !result.isZero()) {
+		result.mkNegative();
+	}
+	return result;
+}
+
 // https://en.wikipedia.org/wiki/Division_algorithm
 ArbNumDivide ArbNum::divideWithRem(const ArbNum &dividend, const ArbNum &divisor) {
 	ArbNumDivide result;
@@ -866,73 +4029,295 @@ ArbNumDivide ArbNum::divideWithRem(const ArbNum &dividend, const ArbNum &divisor
 	return result;
 }
 
-ArbNum ArbNum::divide(const ArbNum &dividend, const ArbNum &divisor) {
-	return divideWithRem(dividend, divisor).quotient;
+ArbNum ArbNum::divide(const ArbNum &dividend, const ArbNum &divisor) {
+	return divideWithRem(dividend, divisor).quotient;
+}
+
+ArbNum ArbNum::mod(const ArbNum &dividend, const ArbNum &divisor) {
+	return divideWithRem(dividend, divisor).remainder;
+}
+
+ArbNum ArbNum::min(const ArbNum &a, const ArbNum &b) {
+	return a < b ? a : b;
+}
+
+ArbNum ArbNum::max(const ArbNum &a, const ArbNum &b) {
+	return a > b ? a : b;
+}
+
+ArbNum ArbNum::doNot(const ArbNum &a) {
+	return a.isZero() ? gArbNumOne : gArbNumZero;
+}
+
+ArbNum ArbNum::pow(const ArbNum &a, const ArbNum &n) {
+	ArbNum result = Unsigned::pow(a.mUnsigned, n.mUnsigned);
+	if (result.isZero() && !a.isZero()) {
+		result.mkError();
+		return result;
+	}
+
+	if (a.isNegative()) {
+		result.mSign = n.mUnsigned.isEven() ? 1 : -1;
+	}
+
+	return result;
+}
+
+ArbNum ArbNum::gcd(const ArbNum &a, const ArbNum &b) {
+	return Unsigned::gcd(a.mUnsigned, b.mUnsigned);
+}
+
+// Returns gcd(a, b) = a * x + b * y
+ArbNum ArbNum::gcdExtended(const ArbNum &a, const ArbNum &b, ArbNum &x, ArbNum &y) {
+	Unsigned cofactor;
+	bool negative;
+	const ArbNum g = Unsigned::gcdExtended(a.mUnsigned, b.mUnsigned, cofactor, negative);
+
+	x = cofactor;
+	if (negative != a.isNegative()) {
+		x.flipSign();
+	}
+	y = b.isZero() ? ArbNum(0) : (g - a * x) / b;
+	return g;
+}
+
+// x with a * x = 1 (mod m), 0 <= x < m
+ArbNum ArbNum::modInverse(const ArbNum &a, const ArbNum &m) {
+	ArbNum result;
+
+	if (m.isNegativeOrZero() || m.isZero()) {
+		fprintf(stderr, "Modulus must be positive\n");
+		result.mkError();
+		return result;
+	}
+
+	ArbNum x, y;
+	if (gcdExtended(a, m, x, y) != gArbNumOne) {
+		fprintf(stderr, "No inverse: %s and %s have a common factor\n", a.toString().c_str(), m.toString().c_str());
+		result.mkError();
+		return result;
+	}
+
+	result = x % m;
+	if (result.isNegative()) {
+		result += m;
+	}
+	return result;
+}
+
+// a^e mod m from 0 to m - 1.  A negative e raises the inverse of a.
+ArbNum ArbNum::powMod(const ArbNum &a, const ArbNum &e, const ArbNum &m) {
+	if (m.isNegativeOrZero() || m.isZero()) {
+		fprintf(stderr, "Modulus must be positive\n");
+		ArbNum result;
+		result.mkError();
+		return result;
+	}
+
+	const ArbNum base = e.isNegative() ? modInverse(a, m) : a;
+	if (!base.isNormal()) return base;
+
+	ArbNum result = Unsigned::powMod(base.mUnsigned, e.mUnsigned, m.mUnsigned);
+	if (base.isNegative() && e.mUnsigned.isOdd() && !result.isZero()) {
+		result = m - result;
+	}
+	return result;
+}
+
+ArbNum ArbNum::sqrt(const ArbNum &a) {
+	if (a.isNegative()) {
+		ArbNum result;
+		result.mkError();
+		return result;
+	}
+	return Unsigned::sqrt(a.mUnsigned);
+}
+
+// floor(sqrt(a)) with remainder = a - root^2
+ArbNum ArbNum::sqrtRem(const ArbNum &a, ArbNum &remainder) {
+	if (a.isNegative()) {
+		ArbNum result;
+		result.mkError();
+		remainder.mkError();
+		return result;
+	}
+	Unsigned r;
+	const ArbNum root = Unsigned::sqrtRem(a.mUnsigned, r);
+	remainder = r;
+	return root;
+}
+
+ArbNum ArbNum::isPerfectSquare(const ArbNum &a) {
+	if (a.isNegative()) return false;
+	return Unsigned::isPerfectSquare(a.mUnsigned);
+}
+
+// The k-th root rounded toward zero.  Negative numbers have odd roots.
+ArbNum ArbNum::root(const ArbNum &a, const ArbNum &k) {
+	if (k.isNegativeOrZero() || k.isZero() || (a.isNegative() && k.mUnsigned.isEven())) {
+		fprintf(stderr, "No root %s of %s\n", k.toString().c_str(), a.toString().c_str());
+		ArbNum result;
+		result.mkError();
+		return result;
+	}
+
+	const Unsigned::limb_t limbK = k > ArbNum((long long)0xFFFFFFFF) ? 0xFFFFFFFF : (Unsigned::limb_t)k.toLongLong();
+	ArbNum result = Unsigned::root(a.mUnsigned, limbK);
+	if (a.isNegative()) {
+		result.flipSign();
+	}
+	return result;
+}
+
+// a = b^k for some b and k >= 2, including -8 = (-2)^3
+ArbNum ArbNum::isPerfectPower(const ArbNum &a) {
+	// Only an odd power can be negative
+	return Unsigned::isPerfectPower(a.mUnsigned, a.isNegative());
 }
 
-ArbNum ArbNum::mod(const ArbNum &dividend, const ArbNum &divisor) {
-	return divideWithRem(dividend, divisor).remainder;
+ArbNum ArbNum::random(const ArbNum &n) {
+	return Unsigned::random(n.mUnsigned);
 }
 
-ArbNum ArbNum::min(const ArbNum &a, const ArbNum &b) {
-	return a < b ? a : b;
+ArbNum ArbNum::isPrime(const ArbNum &a) {
+	if (a.isNegative()) return false;
+	return Unsigned::isPrime(a.mUnsigned);
 }
 
-ArbNum ArbNum::max(const ArbNum &a, const ArbNum &b) {
-	return a > b ? a : b;
+// isPrime() with extra Miller-Rabin rounds
+ArbNum ArbNum::isProbablePrime(const ArbNum &a, const ArbNum &rounds) {
+	if (a.isNegative()) return false;
+	return Unsigned::isProbablePrime(a.mUnsigned, rounds.isNegative() ? 0 : rounds.toInt());
 }
 
-ArbNum ArbNum::doNot(const ArbNum &a) {
-	return a.isZero() ? gArbNumOne : gArbNumZero;
+ArbNum ArbNum::nextPrime(const ArbNum &a) {
+	if (a.isNegative()) return ArbNum(2);
+	return Unsigned::nextPrime(a.mUnsigned);
 }
 
-ArbNum ArbNum::pow(const ArbNum &a, const ArbNum &n) {
-	ArbNum result = Unsigned::pow(a.mUnsigned, n.mUnsigned);
+// Primes p with lo <= p < hi
+ArbNum ArbNum::countPrimes(const ArbNum &lo, const ArbNum &hi) {
+	const ArbNum from = lo.isNegative() ? gArbNumZero : lo;
+	if (hi <= from) return gArbNumZero;
 
-	if (a.isNegative()) {
-		result.mSign = n.mUnsigned.isEven() ? 1 : -1;
+	if (hi - from > ArbNum((long long)0xFFFFFFFF)) {
+		fprintf(stderr, "Range too big: %s numbers\n", (hi - from).toString().c_str());
+		ArbNum result;
+		result.mkError();
+		return result;
 	}
-
-	return result;
+	return Unsigned::countPrimes(from.mUnsigned, hi.mUnsigned);
 }
 
-ArbNum ArbNum::gcd(const ArbNum &a, const ArbNum &b) {
-	return Unsigned::gcd(a.mUnsigned, b.mUnsigned);
+// Factorial arguments must fit in a limb: anything bigger wouldn't fit in memory
+static bool factorialArgument(const ArbNum &a, Unsigned::limb_t &n) {
+	if (a > ArbNum((long long)0xFFFFFFFF)) {
+		fprintf(stderr, "Too big for a factorial: %s\n", a.toString().c_str());
+		return false;
+	}
+	n = a < gArbNumZero ? 0 : (Unsigned::limb_t)a.toLongLong();
+	return true;
 }
 
-ArbNum ArbNum::sqrt(const ArbNum &a) {
-	if (a.isNegative()) {
+ArbNum ArbNum::factorial(const ArbNum &count) {
+	Unsigned::limb_t n;
+	if (!factorialArgument(count, n)) {
 		ArbNum result;
 		result.mkError();
 		return result;
 	}
-	return Unsigned::sqrt(a.mUnsigned);
+	return Unsigned::factorial(n);
 }
 
-ArbNum ArbNum::random(const ArbNum &n) {
-	return Unsigned::random(n.mUnsigned);
+ArbNum ArbNum::doubleFactorial(const ArbNum &count) {
+	Unsigned::limb_t n;
+	if (!factorialArgument(count, n)) {
+		ArbNum result;
+		result.mkError();
+		return result;
+	}
+	return Unsigned::doubleFactorial(n);
 }
 
-ArbNum ArbNum::isPrime(const ArbNum &a) {
-	if (a.isNegative()) return false;
-	return Unsigned::isPrime(a.mUnsigned);
+// n! / k!, rounded down like divide() when k > n
+ArbNum ArbNum::partialFactorial(const ArbNum &count, const ArbNum &below) {
+	Unsigned::limb_t n, k;
+	if (!factorialArgument(count, n) || !factorialArgument(below, k)) {
+		ArbNum result;
+		result.mkError();
+		return result;
+	}
+	if (k > n) return gArbNumZero;
+	return Unsigned::factorialRatio(n, k);
 }
 
-ArbNum ArbNum::factorial(const ArbNum &count) {
-	if (count <= gArbNumOne) return gArbNumOne;
-	return factorial(count - gArbNumOne) * count;
+// this += other with other's sign taken as otherSign.  Working on the magnitude in place means
+// sum += x only allocates when the sum outgrows its limbs.  Like the signs, a zero result is
+// positive.
+void ArbNum::addSigned(const ArbNum &other, const int otherSign) {
+	mSpecial = SPEC_NORMAL;
+	if ((mSign >= 0) == (otherSign >= 0)) {
+		Unsigned::addMutable(mUnsigned, other.mUnsigned);
+		return;
+	}
+
+	const int order = Unsigned::compare(mUnsigned, other.mUnsigned);
+	if (order < 0) {
+		Unsigned::subtractFromMutable(mUnsigned, other.mUnsigned);
+		mSign = otherSign >= 0 ? 1 : -1;
+	}
+	else {
+		Unsigned::subtractMutable(mUnsigned, other.mUnsigned);
+		if (order == 0) mkPositive();
+	}
 }
 
 void ArbNum::add(const ArbNum &other) {
-	set(add(*this, other));
+	addSigned(other, other.mSign);
 }
 
 void ArbNum::subtract(const ArbNum &other) {
-	set(subtract(*this, other));
+	addSigned(other, -other.mSign);
 }
 
 void ArbNum::multiply(const ArbNum &other) {
-	set(multiply(*this, other));
+	mSpecial = SPEC_NORMAL;
+	mUnsigned = Unsigned::multiply(mUnsigned, other.mUnsigned);
+	mSign *= other.mSign;
+}
+
+// this += a * b with the product's sign taken as productSign.  When the signs agree the product
+// is added as it's worked out.
+void ArbNum::addProductSigned(const ArbNum &a, const ArbNum &b, const int productSign) {
+	if ((mSign >= 0) == (productSign >= 0)) {
+		mSpecial = SPEC_NORMAL;
+		Unsigned::addProductMutable(mUnsigned, a.mUnsigned, b.mUnsigned);
+		return;
+	}
+
+	const ArbNum product = Unsigned::multiply(a.mUnsigned, b.mUnsigned);
+	addSigned(product, productSign);
+}
+
+// this = a * b, in this's own limbs when they're big enough
+void ArbNum::setProduct(const ArbNum &a, const ArbNum &b) {
+	if (this == &a || this == &b) {
+		multiply(this == &a ? b : a);
+		return;
+	}
+
+	mSpecial = SPEC_NORMAL;
+	mSign = a.mSign * b.mSign;
+	mUnsigned.clear();
+	Unsigned::addProductMutable(mUnsigned, a.mUnsigned, b.mUnsigned);
+}
+
+void ArbNum::addProduct(const ArbNum &a, const ArbNum &b) {
+	addProductSigned(a, b, a.mSign * b.mSign);
+}
+
+void ArbNum::subtractProduct(const ArbNum &a, const ArbNum &b) {
+	addProductSigned(a, b, -a.mSign * b.mSign);
 }
 
 void ArbNum::divide(const ArbNum &other) {
@@ -979,7 +4364,7 @@ int ArbNum::toInt() const {
 		return -1;
 	}
 
-	return atoi(toString().c_str());
+	return (int)toLongLong();
 }
 
 long ArbNum::toLong() const {
@@ -995,16 +4380,12 @@ long ArbNum::toLong() const {
 		return -1;
 	}
 
-	return atol(toString().c_str());
+	return (long)toLongLong();
 }
 
 long long ArbNum::toLongLong() const {
-#if defined(_MSC_VER) && _MSC_VER <= 1400
-#pragma message("Sorry " __FUNCTION__ " isn't supported on this compiler")
-	return atol(toString().c_str());
-#else
-	return atoll(toString().c_str());
-#endif
+	const unsigned long long magnitude = mUnsigned.toULongLong();
+	return isNegative() ? (long long)(0ULL - magnitude) : (long long)magnitude;
 }
 
 int ArbNum::compare(const ArbNum &a, const ArbNum &b) {
@@ -1113,6 +4494,45 @@ bool ArbNum::testMultiply(const long a, const long b) {
 	return lResult == lCorrect;
 }
 
+// The in place operators against the long ones, with a temporary and the same number on
+// the left too
+bool ArbNum::testCompound(const long a, const long b) {
+	ArbNum sum(a), difference(a), product(a), twice(a), none(a);
+	sum += b;
+	difference -= b;
+	product *= b;
+	twice += twice;
+	none -= none;
+	const ArbNum chain = ArbNum(a) + ArbNum(b) - ArbNum(b) * ArbNum(b);
+
+	const bool ok = sum.toLong() == a + b && difference.toLong() == a - b && product.toLong() == a * b &&
+		twice.toLong() == 2 * a && none == gArbNumZero && (none -= ArbNum(b)).toLong() == -b &&
+		chain.toLong() == a + b - b * b;
+	if (!ok) {
+		fprintf(stderr, "%ld += -= *= %ld fail\n", a, b);
+	}
+	return ok;
+}
+
+// Lazy expressions against the same formulas with plain operators
+bool ArbNum::testExpression(const long a, const long b) {
+	const ArbNum x(a), y(b), z(a - b), m(b == 0 ? 7 : b);
+
+	const ArbNum fused = lazy(x) + lazy(y) * z;
+	const ArbNum negated = lazy(x) - lazy(y) * z - lazy(z) * z;
+	const ArbNum reduced = lazy(x) * y % m;
+	const ArbNum nested = (lazy(x) + y) * (lazy(z) - 3) % m + x;
+	ArbNum reused(z);
+	assign(reused, lazy(reused) * y + reused);
+
+	const bool ok = fused == x + y * z && negated == x - y * z - z * z && reduced == x * y % m &&
+		nested == (x + y) * (z - ArbNum(3)) % m + x && reused == z * y + z;
+	if (!ok) {
+		fprintf(stderr, "Expressions with %ld and %ld fail\n", a, b);
+	}
+	return ok;
+}
+
 bool ArbNum::testDivide(const long a, const long b) {
 	const long lResult = ArbNum::divide(a, b).toLong();
 	const long lCorrect = a / b;
@@ -1154,62 +4574,755 @@ bool ArbNum::testGcd(const long a, const long b) {
 	if (lResult != lCorrect) {
 		fprintf(stderr, "gcd(%ld, %ld) = %ld (ArbNum) != %ld (long) fail\n", a, b, lResult, lCorrect);
 	}
-	return lResult == lCorrect;
+	return lResult == lCorrect;
+}
+
+long ArbNum::sqrtLong(const long s) {
+	if (s < 0) {
+		return sqrtLong(::abs(s));
+	}
+	return (long) ::sqrt((double)s);
+}
+
+bool ArbNum::testSqrt(const long a) {
+	const long lResult = ArbNum::sqrt(a).toLong();
+	const long lCorrect = sqrtLong(a);
+	if (lResult != lCorrect) {
+		fprintf(stderr, "sqrt(%ld) = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
+	}
+	return lResult == lCorrect;
+}
+
+// By Soma Mbadiwe on https://stackoverflow.com/questions/15743192/check-if-number-is-prime-number
+long ArbNum::isPrimeLong(const long a) {
+	if (a <= 1) return false;
+	if (a == 2 || a == 3 || a == 5) return true;
+	if (a % 2 == 0 || a % 3 == 0 || a % 5 == 0) return false;
+
+	const long boundary = (long)::sqrt((double)a);
+	for (long i = 6; i <= boundary; i += 6) {
+		if (a % (i + 1) == 0 || a % (i + 5) == 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ArbNum::testIsPrime(const long a) {
+	const long lResult = ArbNum::isPrime(a).toLong();
+	const long lCorrect = isPrimeLong(a);
+	if (lResult != lCorrect) {
+		fprintf(stderr, "isPrime(%ld) = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
+	}
+	return lResult == lCorrect;
+}
+
+long ArbNum::factorialLong(const long n) {
+	if (n <= 1) return 1;
+	return factorialLong(n - 1) * n;
+}
+
+bool ArbNum::testFactorial(const long a) {
+	const long lResult = ArbNum::factorial(a).toLong();
+	const long lCorrect = factorialLong(a);
+	if (lResult != lCorrect) {
+		fprintf(stderr, "%ld! = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
+	}
+	return lResult == lCorrect;
+}
+
+// base^n against one multiply at a time for every n up to maxExponent.  An even base to
+// 2^64 + 1, or a multiple of 4 to 2^63, would shift past any size_t, so it must be an
+// error instead of wrapping.
+bool ArbNum::testPow(const char *base, const long maxExponent) {
+	const ArbNum a(base);
+	ArbNum product(1);
+	for (long n = 0; n <= maxExponent; n++) {
+		const ArbNum result = pow(a, ArbNum(n));
+		if (result != product) {
+			fprintf(stderr, "%s ^ %ld = %s fail\n", base, n, result.toString().c_str());
+			return false;
+		}
+		product *= a;
+	}
+
+	const char *huge[] = { "18446744073709551617", "9223372036854775808" };
+	const int nHuge = a % ArbNum(4) == gArbNumZero ? 2 : a % ArbNum(2) == gArbNumZero ? 1 : 0;
+	for (int i = 0; a != gArbNumZero && i < nHuge; i++) {
+		if (!pow(a, ArbNum(huge[i])).isError()) {
+			fprintf(stderr, "%s ^ %s fail\n", base, huge[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ArbNum::testPowerOfTen(const long n) {
+	const bool ok = pow(ArbNum(10), ArbNum(n)) == powerOfTenBySaving(n);
+	if (!ok) {
+		fprintf(stderr, "10 ^ %ld fail\n", n);
+	}
+	return ok;
+}
+
+// powMod() against pow() then mod for an odd modulus of about digits digits, that times 2^5,
+// and a power of two.  Montgomery products against multiply() then mod.
+bool ArbNum::testPowMod(const long digits, const long exponent) {
+	const ArbNum odd = powerOfTenBySaving(digits) / ArbNum(7) + ArbNum(1);
+	const ArbNum moduli[] = { odd.mUnsigned.isOdd() ? odd : odd + gArbNumOne, odd * ArbNum(32), pow(ArbNum(2), ArbNum(digits * 3)) };
+	const ArbNum a = powerOfTenBySaving(digits + 3) / ArbNum(13);
+	const ArbNum b = powerOfTenBySaving(digits) / ArbNum(3);
+
+	for (size_t i = 0; i < sizeof(moduli) / sizeof(moduli[0]); i++) {
+		const ArbNum &m = moduli[i];
+		if (powMod(a, ArbNum(exponent), m) != pow(a, ArbNum(exponent)) % m) {
+			fprintf(stderr, "powMod(10^%ld / 13, %ld, m) fail for modulus %d\n", digits + 3, exponent, (int)i);
+			return false;
+		}
+	}
+
+	const Montgomery montgomery(moduli[0].mUnsigned);
+	const Unsigned product = montgomery.fromMontgomery(montgomery.mulMod(montgomery.toMontgomery(a.mUnsigned), montgomery.toMontgomery(b.mUnsigned)));
+	const Unsigned square = montgomery.fromMontgomery(montgomery.sqrMod(montgomery.toMontgomery(b.mUnsigned)));
+	if (product != (a * b % moduli[0]).mUnsigned || square != (b * b % moduli[0]).mUnsigned) {
+		fprintf(stderr, "Montgomery mulMod() or sqrMod() with %ld digits fail\n", digits);
+		return false;
+	}
+	return true;
+}
+
+// 3^(p - 1) = 1 mod p for a Mersenne prime p = 2^exponent - 1
+bool ArbNum::testFermat(const long exponent) {
+	const ArbNum p = pow(ArbNum(2), ArbNum(exponent)) - gArbNumOne;
+	const bool ok = powMod(ArbNum(3), p - gArbNumOne, p) == gArbNumOne && powMod(ArbNum(3), p, p) == ArbNum(3);
+	if (!ok) {
+		fprintf(stderr, "3^(p - 1) mod p for p = 2^%ld - 1 fail\n", exponent);
+	}
+	return ok;
+}
+
+// The root and remainder of 10^digits / 7 against their definition, and isPerfectSquare()
+// of the root squared and its neighbours
+bool ArbNum::testBigSqrt(const long digits) {
+	const ArbNum a = powerOfTenBySaving(digits) / ArbNum(7);
+	ArbNum remainder;
+	const ArbNum root = sqrtRem(a, remainder);
+	const ArbNum next = root + gArbNumOne;
+	const ArbNum square = root * root;
+
+	const bool ok = square + remainder == a && next * next > a && sqrt(a) == root &&
+		isPerfectSquare(square).toInt() != 0 && isPerfectSquare(square + gArbNumOne).toInt() == 0 &&
+		isPerfectSquare(square - gArbNumOne).toInt() == 0 && isPerfectSquare(a).toInt() == 0;
+	if (!ok) {
+		fprintf(stderr, "sqrt(10^%ld / 7) fail\n", digits);
+	}
+	return ok;
+}
+
+// k-th roots of 10^digits / 7 against their definition, and isPerfectPower() of the root to
+// the k and its neighbour
+bool ArbNum::testBigRoot(const long digits) {
+	const ArbNum a = powerOfTenBySaving(digits) / ArbNum(7);
+	const long ks[] = { 3, 5, 7, 10, 31, 100 };
+	for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		const ArbNum k(ks[i]);
+		const ArbNum r = root(a, k);
+		const ArbNum power = pow(r, k);
+		bool ok = power <= a && pow(r + gArbNumOne, k) > a;
+		if (ok && r > ArbNum(2)) {
+			ok = isPerfectPower(power).toInt() != 0 && isPerfectPower(power + gArbNumOne).toInt() == 0;
+		}
+		if (ok && ks[i] % 2 != 0) {
+			ok = root(gArbNumZero - a, k) == gArbNumZero - r;
+		}
+		if (!ok) {
+			fprintf(stderr, "root(10^%ld / 7, %ld) fail\n", digits, ks[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+// Lazy expressions on numbers around 10^digits, on both sides of the fused schoolbook rows
+bool ArbNum::testBigExpression(const long digits) {
+	const ArbNum a = powerOfTenBySaving(digits) / ArbNum(7);
+	const ArbNum b = gArbNumZero - powerOfTenBySaving(digits / 2) / ArbNum(3);
+	const ArbNum c = powerOfTenBySaving(digits) / ArbNum(11) + ArbNum(5);
+	const ArbNum m = powerOfTenBySaving(digits / 3 + 1) / ArbNum(13);
+
+	ArbNum sum = a;
+	assign(sum, lazy(a) * b + lazy(c) * c - lazy(a) * a);
+	const ArbNum reduced = lazy(a) * c % m;
+	const ArbNum negative = lazy(b) * c % m;
+
+	const bool ok = sum == a * b + c * c - a * a && reduced == a * c % m && negative == b * c % m;
+	if (!ok) {
+		fprintf(stderr, "Expressions with %ld digits fail\n", digits);
+	}
+	return ok;
+}
+
+// The same sums, products and quotients of numbers around 10^digits from an arena, a pool and a
+// pool whose numbers were started by standard()
+// The arena's largest and limit fallbacks, its blocks coming back after reset() and the pool's
+// size classes, then all ones numbers of about limbs limbs worked out in each
+bool ArbNum::testAllocator(const long limbs) {
+	const size_t largest = 4096;
+	const size_t blockBytes = (size_t)1 << 20;
+	LimbArena arena(largest, 2 * blockBytes);
+	bool ok = true;
+
+	if (&arena.allocatorFor(largest) != &arena || &arena.allocatorFor(largest + 1) != &LimbAllocator::standard()) {
+		fprintf(stderr, "LimbArena gave out more than %d bytes\n", (int)largest);
+		ok = false;
+	}
+
+	// Up to the limit twice, the second time in the same memory
+	std::vector<void *> taken[2];
+	for (int round = 0; round < 2; round++) {
+		while (&arena.allocatorFor(largest) == &arena) {
+			taken[round].push_back(arena.allocate(largest));
+		}
+		arena.reset();
+	}
+	if (taken[0].size() != 2 * blockBytes / largest || taken[0] != taken[1]) {
+		fprintf(stderr, "LimbArena gave %d then %d buffers before its limit\n", (int)taken[0].size(), (int)taken[1].size());
+		ok = false;
+	}
+
+	LimbPool pool;
+	void *p = pool.allocate(1000);
+	pool.release(p, 1000);
+	void *q = pool.allocate(700);
+	pool.release(q, 700);
+	if (p != q || &pool.allocatorFor((size_t)1 << 17) != &LimbAllocator::standard()) {
+		fprintf(stderr, "LimbPool size classes fail\n");
+		ok = false;
+	}
+
+	// Both sides of largest, and past the limit once limbs is big
+	const ArbNum a = pow(ArbNum(2), ArbNum(32 * limbs)) - gArbNumOne;
+	const ArbNum b = pow(ArbNum(2), ArbNum(16 * limbs + 16)) - ArbNum(3);
+	const ArbNum expected = (a * b + a) / b - a % b;
+	ArbNum results[3];
+	for (int round = 0; round < 2; round++) {
+		std::string fromArena;
+		{
+			const LimbAllocatorScope scope(arena);
+			ArbNum sum(a);
+			sum.multiply(b);
+			sum += a;
+			fromArena = (sum / b - a % b).toString();
+		}
+		arena.reset();
+		results[0] = fromArena.c_str();
+
+		ArbNum started(a);
+		const LimbAllocatorScope scope(pool);
+		ArbNum sum(a);
+		sum.multiply(b);
+		sum += a;
+		results[1] = sum / b - a % b;
+		started.multiply(b);
+		started += a;
+		results[2] = started / b - a % b;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		if (results[i] != expected) {
+			fprintf(stderr, "Allocator %d with %ld limbs fail\n", i, limbs);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+// Dividing, taking square roots and multiplying numbers of about limbs limbs again, on one
+// thread, leaves the workspace the size the first time made it and takes no new buffers
+bool ArbNum::testScratch(const long limbs) {
+	const int saveThreads = Unsigned::getThreads();
+	Unsigned::setThreads(1);
+
+	const ArbNum a = pow(ArbNum(2), ArbNum(32 * limbs)) - gArbNumOne;
+	const ArbNum b = pow(ArbNum(2), ArbNum(16 * limbs + 16)) - ArbNum(3);
+	const ArbNum c = pow(ArbNum(2), ArbNum(32 * limbs)) - pow(ArbNum(2), ArbNum(16 * limbs)) + gArbNumOne;
+	ArbNum expected[4];
+	ArbNum results[4];
+	bool ok = true;
+
+	size_t limbsBefore = 0;
+	size_t missesBefore = 0;
+	for (int round = 0; round < 3; round++) {
+		ArbNum *out = round == 0 ? expected : results;
+		const ArbNumDivide division = divideWithRem(a * c, b);
+		out[0] = division.quotient;
+		out[1] = division.remainder;
+		out[2] = sqrtRem(a * c, out[3]);
+		out[2] = out[2] * c + out[3];
+
+		// The first round into results still gives it buffers of its own
+		if (round == 2 && (workspace().total() != limbsBefore || gLimbCache.misses != missesBefore)) {
+			fprintf(stderr, "Scratch with %ld limbs grew %d limbs and %d buffers\n", limbs,
+				(int)(workspace().total() - limbsBefore), (int)(gLimbCache.misses - missesBefore));
+			ok = false;
+		}
+		limbsBefore = workspace().total();
+		missesBefore = gLimbCache.misses;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (results[i] != expected[i]) {
+			fprintf(stderr, "Scratch with %ld limbs result %d fail\n", limbs, i);
+			ok = false;
+		}
+	}
+	Unsigned::setThreads(saveThreads);
+	return ok;
+}
+
+// n! against one multiply at a time, and the double and partial factorials against n!
+bool ArbNum::testBigFactorial(const long n) {
+	ArbNum product(1);
+	for (long i = 2; i <= n; i++) {
+		product *= ArbNum(i);
+	}
+	const ArbNum result = factorial(ArbNum(n));
+	const ArbNum doubles = doubleFactorial(ArbNum(n)) * doubleFactorial(ArbNum(n - 1));
+	const ArbNum partial = partialFactorial(ArbNum(n), ArbNum(n / 3)) * factorial(ArbNum(n / 3));
+	const ArbNum tail = partialFactorial(ArbNum(n), ArbNum(n - 5)) * factorial(ArbNum(n - 5));
+
+	if (result != product || doubles != product || partial != product || tail != product) {
+		fprintf(stderr, "%ld! fail:%s%s%s%s\n", n, result != product ? " factorial" : "", doubles != product ? " double" : "",
+			partial != product ? " partial" : "", tail != product ? " tail" : "");
+		return false;
+	}
+	return true;
+}
+
+bool ArbNum::testBigStore(const char *in) {
+	const ArbNum arb(in);
+	const std::string result = arb.toString();
+	if (result != in) {
+		fprintf(stderr, "Store Big %s = %s (ArbNum) fail\n", in, result.c_str());
+	}
+	return result == in;
+}
+
+// n digit strings with long runs of zeros, which the divide and conquer conversion must pad
+bool ArbNum::testBigDecimal(const long n) {
+	std::string digits(n, '0');
+	digits[0] = '1';
+	for (long i = 1; i < n; i++) {
+		if ((i / 500) % 3 != 1) {
+			digits[i] = (char)('0' + (i * 7) % 10);
+		}
+	}
+	return testBigStore(digits.c_str()) && powerOfTenBySaving(n).toString() == "1" + std::string(n, '0');
+}
+
+// Checks identities that must hold for numbers too large for a long
+bool ArbNum::testBigArithmetic(const char *aStr, const char *bStr) {
+	const ArbNum a(aStr);
+	const ArbNum b(bStr);
+	bool ok = true;
+
+	if ((a + b) - b != a) {
+		fprintf(stderr, "(%s + %s) - %s fail\n", aStr, bStr, bStr);
+		ok = false;
+	}
+
+	if ((a * b) / b != a || !((a * b) % b).isZero()) {
+		fprintf(stderr, "(%s * %s) / %s fail\n", aStr, bStr, bStr);
+		ok = false;
+	}
+
+	const ArbNumDivide qr = divideWithRem(a, b);
+	if (qr.quotient * b + qr.remainder != a || abs(qr.remainder) >= abs(b)) {
+		fprintf(stderr, "%s / %s = %s rem %s fail\n", aStr, bStr, qr.quotient.toString().c_str(), qr.remainder.toString().c_str());
+		ok = false;
+	}
+
+	return ok;
+}
+
+// 10^n built from a string so it doesn't depend on multiply()
+ArbNum ArbNum::powerOfTenBySaving(const long n) {
+	const std::string digits = "1" + std::string(n, '0');
+	return ArbNum(digits.c_str());
+}
+
+// (10^n - 1) * (10^k - 1) = 10^(n + k) - 10^n - 10^k + 1
+// When n == k the same number is multiplied by itself so squaring gets checked
+bool ArbNum::testBigMultiply(const long n, const long k) {
+	const ArbNum tenN = powerOfTenBySaving(n);
+	const ArbNum tenK = powerOfTenBySaving(k);
+	const ArbNum a = tenN - gArbNumOne;
+	const ArbNum b = tenK - gArbNumOne;
+	const ArbNum result = n == k ? a * a : a * b;
+	const ArbNum correct = powerOfTenBySaving(n + k) - tenN - tenK + gArbNumOne;
+	if (result != correct) {
+		fprintf(stderr, "(10^%ld - 1) * (10^%ld - 1) fail\n", n, k);
+	}
+	return result == correct;
+}
+
+// (10^n - 1) / ((10^k - 1) / 9) with the quotient and remainder checked against the dividend
+bool ArbNum::testBigDivide(const long n, const long k) {
+	const ArbNum a = powerOfTenBySaving(n) - gArbNumOne;
+	const ArbNum b = (powerOfTenBySaving(k) - gArbNumOne) / ArbNum(9) + ArbNum(k);
+	const ArbNumDivide qr = divideWithRem(a, b);
+	const bool ok = qr.quotient * b + qr.remainder == a && qr.remainder < b && !qr.remainder.isNegative();
+	if (!ok) {
+		fprintf(stderr, "(10^%ld - 1) / (%ld ones + %ld) fail\n", n, k, k);
+	}
+	return ok;
+}
+
+// (10^n - 1) / divisor through the single limb path, checked by multiplying back
+bool ArbNum::testDivideSmall(const long n, const Unsigned::limb_t divisor) {
+	const ArbNum a = powerOfTenBySaving(n) - gArbNumOne;
+	const UnsignedDivide qr = Unsigned::divideWithRemSmall(a.mUnsigned, divisor);
+	Unsigned d;
+	d.setULongLong(divisor);
+	const bool ok = qr.quotient * d + qr.remainder == a.mUnsigned && qr.remainder < d &&
+		Unsigned::modSmall(a.mUnsigned, divisor) == qr.remainder.toULongLong();
+	if (!ok) {
+		fprintf(stderr, "(10^%ld - 1) / %lu fail\n", n, (unsigned long)divisor);
+	}
+	return ok;
+}
+
+// gcd(10^n - 1, 10^k - 1) = 10^gcd(n, k) - 1, scaled by a common factor, with the extended gcd
+// both ways round and inverse checked too.  n = 0 makes a zero.
+bool ArbNum::testBigGcd(const long n, const long k) {
+	const ArbNum factor = powerOfTenBySaving(k / 2) + ArbNum(7);
+	const ArbNum a = (powerOfTenBySaving(n) - gArbNumOne) * factor;
+	const ArbNum b = (powerOfTenBySaving(k) - gArbNumOne) * factor;
+	const ArbNum correct = (powerOfTenBySaving(gcdLong(n, k)) - gArbNumOne) * factor;
+	bool ok = true;
+
+	ArbNum x, y;
+	const ArbNum g = gcdExtended(a, b, x, y);
+	ArbNum bx, by;
+	const ArbNum bg = gcdExtended(b, a, bx, by);
+	if (gcd(a, b) != correct || gcd(b, a) != correct || g != correct || a * x + b * y != g
+			|| bg != correct || b * bx + a * by != bg) {
+		fprintf(stderr, "gcd((10^%ld - 1) * f, (10^%ld - 1) * f) fail\n", n, k);
+		ok = false;
+	}
+
+	if (n == 0) {
+		if (modInverse(a, gArbNumOne) != gArbNumZero) {
+			fprintf(stderr, "modinv(0, 1) fail\n");
+			ok = false;
+		}
+		return ok;
+	}
+
+	const ArbNum m = pow(ArbNum(2), ArbNum(3 * k));	// 10^n - 1 is odd
+	const ArbNum inverse = modInverse(a / factor, m);
+	if (inverse * (a / factor) % m != gArbNumOne) {
+		fprintf(stderr, "modinv(10^%ld - 1, 2^%ld) fail\n", n, 3 * k);
+		ok = false;
+	}
+
+	return ok;
+}
+
+// 2^exponent - 1 against what is known about Mersenne numbers
+bool ArbNum::testMersennePrime(const long exponent, const bool prime) {
+	const ArbNum m = pow(ArbNum(2), ArbNum(exponent)) - gArbNumOne;
+	const bool result = isPrime(m).toInt() != 0 && isProbablePrime(m, ArbNum(3)).toInt() != 0;
+	if (result != prime) {
+		fprintf(stderr, "isPrime(2^%ld - 1) = %d fail\n", exponent, (int)result);
+	}
+	return result == prime;
+}
+
+// Composites that fool weaker tests: strong pseudoprimes to base 2 and to several bases, Carmichael numbers
+bool ArbNum::testPseudoprime(const char *composite) {
+	const bool result = isPrime(ArbNum(composite)).toInt() != 0;
+	if (result) {
+		fprintf(stderr, "isPrime(%s) = 1 fail\n", composite);
+	}
+	const bool fixedResult = !FixedUnsigned<128>::isPrime(FixedUnsigned<128>(composite)).isZero();
+	if (fixedResult) {
+		fprintf(stderr, "FixedUnsigned<128>::isPrime(%s) = 1 fail\n", composite);
+	}
+	return !result && !fixedResult;
+}
+
+// Sieving [lo, hi) must find expected primes, in order and all passing isPrime()
+bool ArbNum::testPrimeCount(const char *lo, const char *hi, const long expected) {
+	const Unsigned from(lo), to(hi);
+	const long count = ArbNum(Unsigned::countPrimes(from, to)).toLong();
+	const std::vector<Unsigned> found = Unsigned::primes(from, to);
+
+	bool ok = count == expected && (long)found.size() == expected;
+	for (size_t i = 0; ok && i < found.size(); i++) {
+		ok = found[i] >= from && found[i] < to && (i == 0 || found[i - 1] < found[i]) &&
+			(i % 97 != 0 || Unsigned::isPrime(found[i]).isOne());
+	}
+	if (!ok) {
+		fprintf(stderr, "countPrimes(%s, %s) = %ld with %d listed, expected %ld fail\n", lo, hi, count, (int)found.size(), expected);
+	}
+	return ok;
+}
+
+bool ArbNum::testNextPrime(const char *n, const char *expected) {
+	const ArbNum result = nextPrime(ArbNum(n));
+	if (result != ArbNum(expected)) {
+		fprintf(stderr, "nextPrime(%s) = %s != %s fail\n", n, result.toString().c_str(), expected);
+		return false;
+	}
+	return true;
+}
+
+// The same product with one thread and with several must come out the same
+bool ArbNum::testThreads(const long n, const long k) {
+	const ArbNum a = powerOfTenBySaving(n) - gArbNumOne;
+	const ArbNum b = powerOfTenBySaving(k) / ArbNum(7);
+	const int saveThreads = Unsigned::getThreads();
+	const size_t workersBefore = workerPool().size();
+
+	Unsigned::setThreads(1);
+	const ArbNum single = n == k ? a * a : a * b;
+	Unsigned::setThreads(4);
+	const ArbNum multi = n == k ? a * a : a * b;
+	const ArbNum again = n == k ? a * a : a * b;
+	const bool pooled = workerPool().size() <= std::max(workersBefore, (size_t)3);
+	Unsigned::setThreads(saveThreads);
+	const bool budget = gSpareThreads == saveThreads - 1;
+
+	if (single != multi || single != again) {
+		fprintf(stderr, "%ld and %ld digit multiply differs with threads\n", n, k);
+	}
+	if (!pooled) {
+		fprintf(stderr, "%ld and %ld digit multiply left %d pooled threads for a budget of 4\n", n, k, (int)workerPool().size());
+	}
+	if (!budget) {
+		fprintf(stderr, "%d spare threads of %d after %ld and %ld digit multiply\n", (int)gSpareThreads, saveThreads, n, k);
+	}
+	return single == multi && single == again && pooled && budget;
 }
 
-long ArbNum::sqrtLong(const long s) {
-	if (s < 0) {
-		return sqrtLong(::abs(s));
+// Every kernel set this CPU can run must give the portable answers.  All ones limbs carry and
+// borrow the whole length and multiply with the largest high limbs; limbs odd leaves a limb
+// after the last whole word.
+bool ArbNum::testKernels(const long limbs) {
+	const ArbNum c = pow(ArbNum(2), ArbNum(32 * limbs));
+	const ArbNum a = c - gArbNumOne;
+	const ArbNum b = pow(ArbNum(2), ArbNum(32 * (limbs / 2 + 1))) - gArbNumOne;
+	const std::string saveKernels = Unsigned::getKernels();
+
+	std::vector<ArbNum> expected;
+	const std::vector<const char *> choices = Unsigned::kernelChoices();
+	bool ok = true;
+	for (size_t i = 0; i < choices.size(); i++) {
+		Unsigned::setKernels(choices[i]);
+		std::vector<ArbNum> results;
+		results.push_back(a + a);
+		results.push_back(a + b);
+		results.push_back(c - a);
+		results.push_back(c - b);
+		results.push_back(a * b);
+		results.push_back(a * a);
+		results.push_back(a * a / a);
+		results.push_back((a * c - b) / b);
+		results.push_back((a * c - b) % a);
+		results.push_back(sqrt(a * a - gArbNumOne));
+		if (i == 0) {
+			expected = results;
+		}
+		else if (results != expected) {
+			fprintf(stderr, "%s kernels differ with %ld limbs\n", choices[i], limbs);
+			ok = false;
+		}
 	}
-	return (long) ::sqrt((double)s);
+	Unsigned::setKernels(saveKernels.c_str());
+	return ok;
 }
 
-bool ArbNum::testSqrt(const long a) {
-	const long lResult = ArbNum::sqrt(a).toLong();
-	const long lCorrect = sqrtLong(a);
-	if (lResult != lCorrect) {
-		fprintf(stderr, "sqrt(%ld) = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
-	}
-	return lResult == lCorrect;
+// x mod m in [0, m)
+static ArbNum wrapped(const ArbNum &x, const ArbNum &m) {
+	const ArbNum r = x % m;
+	return r < gArbNumZero ? r + m : r;
 }
 
-// By Soma Mbadiwe on https://stackoverflow.com/questions/15743192/check-if-number-is-prime-number
-long ArbNum::isPrimeLong(const long a) {
-	if (a <= 1) return false;
-	if (a == 2 || a == 3 || a == 5) return true;
-	if (a % 2 == 0 || a % 3 == 0 || a % 5 == 0) return false;
+// FixedUnsigned<Bits> and FixedArbNum<Bits> must give ArbNum's answers cut to Bits bits, with
+// 0 <= a < 2^Bits and 0 < b < 2^Bits
+template <int Bits>
+static bool checkFixed(const ArbNum &a, const ArbNum &b) {
+	typedef FixedUnsigned<Bits> FU;
+	typedef FixedArbNum<Bits> FA;
+	const ArbNum top = ArbNum::pow(ArbNum(2), ArbNum(Bits));
+	const ArbNum half = ArbNum::pow(ArbNum(2), ArbNum(Bits / 2 - 1));
+	const ArbNum m = wrapped(b * ArbNum(3), half) + ArbNum(5);
+	const FU fa(a.toString().c_str()), fb(b.toString().c_str()), fm(m.toString().c_str());
+
+	std::vector<ArbNum> expected, results;
+	expected.push_back(wrapped(a + b, top));
+	results.push_back(ArbNum(Unsigned(fa + fb)));
+	expected.push_back(wrapped(a - b, top));
+	results.push_back(ArbNum(Unsigned(fa - fb)));
+	expected.push_back(wrapped(a * b, top));
+	results.push_back(ArbNum(Unsigned(fa * fb)));
+	expected.push_back(a / b);
+	results.push_back(ArbNum(Unsigned(fa / fb)));
+	expected.push_back(a % b);
+	results.push_back(ArbNum(Unsigned(fa % fb)));
+	expected.push_back(a / ArbNum(7));
+	results.push_back(ArbNum(Unsigned(fa / FU(7))));
+	expected.push_back(wrapped(ArbNum::pow(a, ArbNum(5)), top));
+	results.push_back(ArbNum(Unsigned(FU::pow(fa, FU(5)))));
+	expected.push_back(ArbNum::powMod(a, b, m));
+	results.push_back(ArbNum(Unsigned(FU::powMod(fa, fb, fm))));
+	expected.push_back(ArbNum::gcd(wrapped(a * ArbNum(6), top), m * ArbNum(4)));
+	results.push_back(ArbNum(Unsigned(FU::gcd(fa * FU(6), fm * FU(4)))));
+	expected.push_back(ArbNum(FU::compare(fa, fb) == ArbNum::compare(a, b)));
+	results.push_back(gArbNumOne);
+	expected.push_back(!a);
+	results.push_back(ArbNum(Unsigned(!fa)));
+
+	ArbNum remainder;
+	FU fixedRemainder;
+	expected.push_back(ArbNum::sqrtRem(a, remainder));
+	results.push_back(ArbNum(Unsigned(FU::sqrtRem(fa, fixedRemainder))));
+	expected.push_back(remainder);
+	results.push_back(ArbNum(Unsigned(fixedRemainder)));
+	expected.push_back(ArbNum::isPerfectSquare(a));
+	results.push_back(ArbNum(FU::isPerfectSquare(fa)));
+	const ArbNum root = ArbNum::sqrt(b);
+	expected.push_back(ArbNum::isPerfectSquare(root * root));
+	results.push_back(ArbNum(FU::isPerfectSquare(FU(root.toString().c_str()) * FU(root.toString().c_str()))));
+	const int roots[] = { 3, 5, Bits / 2 - 1, Bits - 1, Bits };
+	for (size_t i = 0; i < sizeof(roots) / sizeof(roots[0]); i++) {
+		expected.push_back(ArbNum::root(a, ArbNum(roots[i])));
+		results.push_back(ArbNum(Unsigned(FU::root(fa, roots[i]))));
+	}
+	expected.push_back(ArbNum::isPrime(a));
+	results.push_back(ArbNum(Unsigned(FU::isPrime(fa))));
+	expected.push_back(ArbNum::isPrime(b));
+	results.push_back(ArbNum(Unsigned(FU::isPrime(fb))));
+	const int factorials[] = { 20, Bits / 2, Bits + 2 };
+	for (size_t i = 0; i < sizeof(factorials) / sizeof(factorials[0]); i++) {
+		expected.push_back(wrapped(ArbNum::factorial(ArbNum(factorials[i])), top));
+		results.push_back(ArbNum(FA::factorial(FA(factorials[i]))));
+		expected.push_back(wrapped(ArbNum::doubleFactorial(ArbNum(factorials[i])), top));
+		results.push_back(ArbNum(FA::doubleFactorial(FA(factorials[i]))));
+		expected.push_back(wrapped(ArbNum::partialFactorial(ArbNum(factorials[i]), ArbNum(factorials[i] / 3)), top));
+		results.push_back(ArbNum(FA::partialFactorial(FA(factorials[i]), FA(factorials[i] / 3))));
+	}
 
-	const long boundary = (long)::sqrt((double)a);
-	for (long i = 6; i <= boundary; i += 6) {
-		if (a % (i + 1) == 0 || a % (i + 5) == 0) {
+	// Past 2^Bits the next prime wraps round to 2
+	const ArbNum next = ArbNum::nextPrime(a);
+	expected.push_back(next < top ? next : ArbNum(2));
+	results.push_back(ArbNum(Unsigned(FU::nextPrime(fa))));
+	expected.push_back(ArbNum::isProbablePrime(b, ArbNum(2)));
+	results.push_back(ArbNum(Unsigned(FU::isProbablePrime(fb, 2))));
+	const ArbNum cube = wrapped(ArbNum::pow(ArbNum::root(a, ArbNum(3)), ArbNum(3)), top);
+	expected.push_back(ArbNum::isPerfectPower(a));
+	results.push_back(ArbNum(FU::isPerfectPower(fa, false)));
+	expected.push_back(ArbNum::isPerfectPower(cube));
+	results.push_back(ArbNum(FU::isPerfectPower(FU(cube.toString().c_str()), false)));
+	if (a + ArbNum(1000) < top) {
+		expected.push_back(ArbNum::countPrimes(a, a + ArbNum(1000)));
+		results.push_back(ArbNum(Unsigned(FU::countPrimes(fa, fa + FU(1000)))));
+	}
+	expected.push_back(gArbNumOne);
+	results.push_back(ArbNum(FU::random(FU(20)) < FU("100000000000000000000")));
+
+	// Signed, kept to half the width so products fit
+	const ArbNum sa = wrapped(a, half) - half / ArbNum(3);
+	const ArbNum sb = half / ArbNum(5) - wrapped(b, half) - gArbNumOne;
+	const FA fsa(sa), fsb(sb);
+	expected.push_back(sa + sb);
+	results.push_back(ArbNum(fsa + fsb));
+	expected.push_back(sa - sb);
+	results.push_back(ArbNum(fsa - fsb));
+	expected.push_back(sa * sb);
+	results.push_back(ArbNum(fsa * fsb));
+	expected.push_back(sa / sb);
+	results.push_back(ArbNum(fsa / fsb));
+	expected.push_back(sa % sb);
+	results.push_back(ArbNum(fsa % fsb));
+	expected.push_back(ArbNum::powMod(sa, m, m));
+	results.push_back(ArbNum(FA::powMod(fsa, FA(m), FA(m))));
+	expected.push_back(ArbNum(sa < sb));
+	results.push_back(ArbNum(fsa < fsb));
+	expected.push_back(ArbNum(fsa.toString().c_str()));
+	results.push_back(sa);
+	expected.push_back(ArbNum::root(sa, ArbNum(3)));
+	results.push_back(ArbNum(FA::root(fsa, FA(3))));
+	expected.push_back(!sb);
+	results.push_back(ArbNum(!fsb));
+	expected.push_back(ArbNum::isPerfectPower(gArbNumZero - cube));
+	results.push_back(ArbNum(FA::isPerfectPower(FA() - FA(FU(cube.toString().c_str())))));
+	expected.push_back(ArbNum::nextPrime(sb));
+	results.push_back(ArbNum(FA::nextPrime(fsb)));
+	expected.push_back(ArbNum::isProbablePrime(sa, ArbNum(-1)));
+	results.push_back(ArbNum(FA::isProbablePrime(fsa, FA(-1))));
+	expected.push_back(ArbNum::countPrimes(sb, sb + ArbNum(1000)));
+	results.push_back(ArbNum(FA::countPrimes(fsb, fsb + FA(1000))));
+
+	// Any cofactors will do, as long as they make the gcd and are no bigger than they need be
+	FA x, y;
+	const ArbNum g = ArbNum(FA::gcdExtended(fsa, fsb, x, y));
+	expected.push_back(ArbNum::gcd(sa, sb));
+	results.push_back(g);
+	expected.push_back(g);
+	results.push_back(sa * ArbNum(x) + sb * ArbNum(y));
+	expected.push_back(gArbNumOne);
+	results.push_back(ArbNum(g == gArbNumZero || ArbNum::abs(ArbNum(x)) <= ArbNum::max(ArbNum::abs(sb) / g, gArbNumOne)));
+	if (ArbNum::gcd(sa, m) == gArbNumOne) {
+		expected.push_back(ArbNum::modInverse(sa, m));
+		results.push_back(ArbNum(FA::modInverse(fsa, FA(m))));
+	}
+
+	for (size_t i = 0; i < expected.size(); i++) {
+		// Through a difference as ArbNum can give a quotient of -0
+		if ((results[i] - expected[i]).toString() != "0") {
+			fprintf(stderr, "FixedUnsigned<%d> check %d with %s and %s gave %s not %s\n", Bits, (int)i,
+				a.toString().c_str(), b.toString().c_str(), results[i].toString().c_str(), expected[i].toString().c_str());
 			return false;
 		}
 	}
-
 	return true;
 }
 
-bool ArbNum::testIsPrime(const long a) {
-	const long lResult = ArbNum::isPrime(a).toLong();
-	const long lCorrect = isPrimeLong(a);
-	if (lResult != lCorrect) {
-		fprintf(stderr, "isPrime(%ld) = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
-	}
-	return lResult == lCorrect;
+// Numbers k from the edges of Bits bits: sums that reach 2^Bits exactly, differences that go
+// below zero, 2^Bits - 1 and products that just cross 2^Bits
+template <int Bits>
+static bool checkFixedEdges(const long k) {
+	const ArbNum top = ArbNum::pow(ArbNum(2), ArbNum(Bits));
+	const ArbNum middle = ArbNum::pow(ArbNum(2), ArbNum(Bits / 2));
+	const ArbNum distance(k);
+	const FixedUnsigned<Bits> allOnes(-1);
+	const FixedUnsigned<Bits> minusK(-(int)k);
+
+	const FixedArbNum<Bits> intMin(INT_MIN), longLongMin(LLONG_MIN);
+
+	return ArbNum(Unsigned(allOnes)) == top - gArbNumOne && ArbNum(Unsigned(minusK)) == top - distance
+		&& intMin.toInt() == INT_MIN && intMin.toLong() == (long)INT_MIN && longLongMin.toLongLong() == LLONG_MIN
+		&& checkFixed<Bits>(top - distance, distance)
+		&& checkFixed<Bits>(distance - gArbNumOne, distance)
+		&& checkFixed<Bits>(top - gArbNumOne, top - distance)
+		&& checkFixed<Bits>(top - distance, top - gArbNumOne)
+		&& checkFixed<Bits>(middle + distance, middle - distance)
+		&& checkFixed<Bits>(middle * distance + gArbNumOne, middle);
 }
 
-long ArbNum::factorialLong(const long n) {
-	if (n <= 1) return 1;
-	return factorialLong(n - 1) * n;
+// Arguments ArbNum turns down too
+template <int Bits>
+static bool checkFixedErrors() {
+	typedef FixedArbNum<Bits> FA;
+	return FA::factorial(FA(0x100000000LL)).isError() && FA::partialFactorial(FA(5), FA(6)).isZero()
+		&& FA::countPrimes(FA(), FA(0x100000000LL)).isError() && FA::countPrimes(FA(-5), FA(-1)).isZero();
 }
 
-bool ArbNum::testFactorial(const long a) {
-	const long lResult = ArbNum::factorial(a).toLong();
-	const long lCorrect = factorialLong(a);
-	if (lResult != lCorrect) {
-		fprintf(stderr, "%ld! = %ld (ArbNum) != %ld (long) fail\n", a, lResult, lCorrect);
-	}
-	return lResult == lCorrect;
+bool ArbNum::testFixed(const long k) {
+	return checkFixedEdges<128>(k) && checkFixedEdges<256>(k) && checkFixedEdges<512>(k)
+		&& (k != 1 || checkFixedErrors<128>());
 }
 
 bool ArbNum::testAll() {
@@ -1319,6 +5432,30 @@ bool ArbNum::testAll() {
 		}
 	}
 
+	for (a = A_START; a <= A_END; a += A_INC) {
+		printf("Testing compound assignment with %ld on the left\n", a);
+		for (b = B_START; b >= B_END; b -= B_DEC) {
+			if (testCompound(a, b)) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
+	for (a = A_START; a <= A_END; a += 7 * A_INC) {
+		printf("Testing expressions with %ld on the left\n", a);
+		for (b = B_START; b >= B_END; b -= 7 * B_DEC) {
+			if (testExpression(a, b)) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
 	for (a = -10; a < 10; a++) {
 		printf("Testing pow with %ld on the left\n", a);
 		for (b = 1; b <= 9; b++) {
@@ -1367,6 +5504,19 @@ bool ArbNum::testAll() {
 		}
 	}
 
+	// The steps above never reach 0
+	const long checkGcdZero[] = { 0, 1, -88, 4294967296L, LONG_MAX };
+	const int nCheckGcdZero = sizeof(checkGcdZero) / sizeof(checkGcdZero[0]);
+	printf("Testing gcd with 0\n");
+	for (int i = 0; i < nCheckGcdZero; i++) {
+		if (testGcd(0, checkGcdZero[i]) && testGcd(checkGcdZero[i], 0)) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
 	for (a = 0; a <= A_END; a += A_INC) {
 		printf("Testing sqrt with %ld\n", a);
 		if (testSqrt(a)) {
@@ -1397,6 +5547,317 @@ bool ArbNum::testAll() {
 		}
 	}
 
+	const char *checkPows[] = { "0", "1", "2", "3", "-3", "10", "-12", "65535", "4294967296", "4294967297", "12345678901234567890" };
+	printf("Testing powers\n");
+	for (size_t i = 0; i < sizeof(checkPows) / sizeof(checkPows[0]); i++) {
+		if (testPow(checkPows[i], 300)) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkPowersOfTen[] = { 1, 19, 20, 1000, 54321 };
+	printf("Testing powers of ten\n");
+	for (size_t i = 0; i < sizeof(checkPowersOfTen) / sizeof(checkPowersOfTen[0]); i++) {
+		if (testPowerOfTen(checkPowersOfTen[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkPowMods[][2] = { { 5, 3 }, { 20, 17 }, { 100, 64 }, { 480, 31 }, { 2000, 9 }, { 4000, 11 } };
+	printf("Testing powMod\n");
+	for (size_t i = 0; i < sizeof(checkPowMods) / sizeof(checkPowMods[0]); i++) {
+		if (testPowMod(checkPowMods[i][0], checkPowMods[i][1])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkFermat[] = { 61, 127, 521, 1279, 2203 };
+	printf("Testing Fermat's little theorem\n");
+	for (size_t i = 0; i < sizeof(checkFermat) / sizeof(checkFermat[0]); i++) {
+		if (testFermat(checkFermat[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkBigSqrt[] = { 2, 10, 19, 20, 39, 40, 100, 1001, 10000, 40000 };
+	printf("Testing big square roots\n");
+	for (size_t i = 0; i < sizeof(checkBigSqrt) / sizeof(checkBigSqrt[0]); i++) {
+		if (testBigSqrt(checkBigSqrt[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkBigExpression[] = { 20, 200, 300, 2000, 20000 };
+	printf("Testing big expressions\n");
+	for (size_t i = 0; i < sizeof(checkBigExpression) / sizeof(checkBigExpression[0]); i++) {
+		if (testBigExpression(checkBigExpression[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkAllocator[] = { 3, 1023, 1024, 1025, 20000 };
+	printf("Testing limb allocators\n");
+	for (size_t i = 0; i < sizeof(checkAllocator) / sizeof(checkAllocator[0]); i++) {
+		if (testAllocator(checkAllocator[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkScratch[] = { 59, 60, 300, 800, 2500 };
+	printf("Testing scratch space\n");
+	for (size_t i = 0; i < sizeof(checkScratch) / sizeof(checkScratch[0]); i++) {
+		if (testScratch(checkScratch[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkBigRoot[] = { 2, 20, 100, 1001, 10000 };
+	printf("Testing big roots\n");
+	for (size_t i = 0; i < sizeof(checkBigRoot) / sizeof(checkBigRoot[0]); i++) {
+		if (testBigRoot(checkBigRoot[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkBigFactorial[] = { 5, 36, 100, 1001, 4000, 10000 };
+	printf("Testing big factorials\n");
+	for (size_t i = 0; i < sizeof(checkBigFactorial) / sizeof(checkBigFactorial[0]); i++) {
+		if (testBigFactorial(checkBigFactorial[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const char *checkBig[] = {
+		"4294967295", "4294967296", "18446744073709551615", "18446744073709551616",
+		"100000000000000000000000000000000000000", "-123456789012345678901234567890123456789",
+		"340282366920938463463374607431768211455", "340282366920938463463374607431768211456", "1000000000000000000000000000000000000000000000000000001",
+		"39614081257132168796771975171", "9903520314283042199192993793" };	// 2^95 + 3 and 2^93 + 1 need the add back step
+	const int nCheckBig = sizeof(checkBig) / sizeof(checkBig[0]);
+	for (int i = 0; i < nCheckBig; i++) {
+		printf("Testing store big %s\n", checkBig[i]);
+		if (testBigStore(checkBig[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	for (int i = 0; i < nCheckBig; i++) {
+		printf("Testing big arithmetic with %s on the left\n", checkBig[i]);
+		for (int j = 0; j < nCheckBig; j++) {
+			if (testBigArithmetic(checkBig[i], checkBig[j])) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
+	const long checkDecimalDigits[] = { 360, 361, 400, 1000, 4321, 20000, 100000 };
+	const int nCheckDecimalDigits = sizeof(checkDecimalDigits) / sizeof(checkDecimalDigits[0]);
+	for (int i = 0; i < nCheckDecimalDigits; i++) {
+		printf("Testing decimal conversion with %ld digits\n", checkDecimalDigits[i]);
+		if (testBigDecimal(checkDecimalDigits[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkMultiplyDigits[] = { 1, 9, 10, 300, 301, 700, 1500, 3001, 5000, 12000 };
+	const int nCheckMultiplyDigits = sizeof(checkMultiplyDigits) / sizeof(checkMultiplyDigits[0]);
+	for (int i = 0; i < nCheckMultiplyDigits; i++) {
+		printf("Testing big multiply with %ld digits on the left\n", checkMultiplyDigits[i]);
+		for (int j = 0; j < nCheckMultiplyDigits; j++) {
+			if (testBigMultiply(checkMultiplyDigits[i], checkMultiplyDigits[j])) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
+	const long checkDivideDigits[] = { 1, 9, 10, 19, 20, 100, 1000, 3000, 20000 };
+	const int nCheckDivideDigits = sizeof(checkDivideDigits) / sizeof(checkDivideDigits[0]);
+	for (int i = 0; i < nCheckDivideDigits; i++) {
+		printf("Testing big divide with %ld digits on the left\n", checkDivideDigits[i]);
+		for (int j = 0; j < nCheckDivideDigits; j++) {
+			if (testBigDivide(checkDivideDigits[i], checkDivideDigits[j])) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
+	const Unsigned::limb_t checkSmallDivisors[] = { 1, 2, 3, 7, 10, 64, 1000000000, 2147483647, 2147483648U, 2147483649U, 4294967295U };
+	const int nCheckSmallDivisors = sizeof(checkSmallDivisors) / sizeof(checkSmallDivisors[0]);
+	for (int i = 0; i < nCheckDivideDigits; i++) {
+		printf("Testing small divisors with %ld digits\n", checkDivideDigits[i]);
+		for (int j = 0; j < nCheckSmallDivisors; j++) {
+			if (testDivideSmall(checkDivideDigits[i], checkSmallDivisors[j])) {
+				nSuccess++;
+			}
+			else {
+				nFail++;
+			}
+		}
+	}
+
+	const long checkBigGcd[][2] = { { 0, 30 }, { 0, 200 }, { 12, 18 }, { 300, 200 }, { 1000, 1001 }, { 6000, 4000 }, { 20000, 15000 } };
+	const int nCheckBigGcd = sizeof(checkBigGcd) / sizeof(checkBigGcd[0]);
+	for (int i = 0; i < nCheckBigGcd; i++) {
+		printf("Testing big gcd with %ld and %ld digits\n", checkBigGcd[i][0], checkBigGcd[i][1]);
+		if (testBigGcd(checkBigGcd[i][0], checkBigGcd[i][1])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkMersenne[] = { 31, 61, 89, 107, 127, 521, 607, 1279 };
+	const long checkNotMersenne[] = { 29, 67, 101, 257, 523 };
+	printf("Testing Mersenne primes\n");
+	for (size_t i = 0; i < sizeof(checkMersenne) / sizeof(checkMersenne[0]); i++) {
+		if (testMersennePrime(checkMersenne[i], true)) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+	for (size_t i = 0; i < sizeof(checkNotMersenne) / sizeof(checkNotMersenne[0]); i++) {
+		if (testMersennePrime(checkNotMersenne[i], false)) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const char *checkPseudoprimes[] = { "2047", "1373653", "25326001", "3215031751", "2152302898747", "3474749660383",
+		"341550071728321", "3825123056546413051", "318665857834031151167461", "3317044064679887385961981",
+		"1000000016000000063", "1000000014000000049", "5316911983139663487003542222693990401" };	// p q and two p^2
+	printf("Testing pseudoprimes\n");
+	for (size_t i = 0; i < sizeof(checkPseudoprimes) / sizeof(checkPseudoprimes[0]); i++) {
+		if (testPseudoprime(checkPseudoprimes[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const struct { const char *lo, *hi; long count; } checkPrimeCounts[] = { { "0", "1000000", 78498 },
+		{ "1000000000000", "1000001000000", 36249 }, { "18446744073709531616", "18446744073709571616", 870 },
+		{ "100000000000000000000", "100000000000000010000", 205 } };
+	printf("Testing prime counts\n");
+	for (size_t i = 0; i < sizeof(checkPrimeCounts) / sizeof(checkPrimeCounts[0]); i++) {
+		if (testPrimeCount(checkPrimeCounts[i].lo, checkPrimeCounts[i].hi, checkPrimeCounts[i].count)) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const char *checkNextPrimes[][2] = { { "-7", "2" }, { "0", "2" }, { "2", "3" }, { "4294967296", "4294967311" },
+		{ "18446744073709551616", "18446744073709551629" }, { "1000000000000000000000000", "1000000000000000000000007" },
+		{ "618970019642690137449562111", "618970019642690137449562141" } };
+	printf("Testing next primes\n");
+	for (size_t i = 0; i < sizeof(checkNextPrimes) / sizeof(checkNextPrimes[0]); i++) {
+		if (testNextPrime(checkNextPrimes[i][0], checkNextPrimes[i][1])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkHugeMultiply[][2] = { { 80000, 80000 }, { 80000, 100000 } };
+	const int nCheckHugeMultiply = sizeof(checkHugeMultiply) / sizeof(checkHugeMultiply[0]);
+	for (int i = 0; i < nCheckHugeMultiply; i++) {
+		printf("Testing huge multiply with %ld and %ld digits\n", checkHugeMultiply[i][0], checkHugeMultiply[i][1]);
+		if (testBigMultiply(checkHugeMultiply[i][0], checkHugeMultiply[i][1])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkThreads[][2] = { { 30000, 30000 }, { 25000, 90000 }, { 90000, 90000 } };
+	const int nCheckThreads = sizeof(checkThreads) / sizeof(checkThreads[0]);
+	for (int i = 0; i < nCheckThreads; i++) {
+		printf("Testing threads with %ld and %ld digits\n", checkThreads[i][0], checkThreads[i][1]);
+		if (testThreads(checkThreads[i][0], checkThreads[i][1])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkKernelLimbs[] = { 1, 2, 3, 33, 34, 61, 301, 800, 2001, 8001 };
+	const int nCheckKernelLimbs = sizeof(checkKernelLimbs) / sizeof(checkKernelLimbs[0]);
+	for (int i = 0; i < nCheckKernelLimbs; i++) {
+		printf("Testing kernels with %ld limbs\n", checkKernelLimbs[i]);
+		if (testKernels(checkKernelLimbs[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
+	const long checkFixedEdges[] = { 1, 2, 3, 159, 189, 569, 65536 };
+	const int nCheckFixedEdges = sizeof(checkFixedEdges) / sizeof(checkFixedEdges[0]);
+	for (int i = 0; i < nCheckFixedEdges; i++) {
+		printf("Testing fixed width %ld from the edges\n", checkFixedEdges[i]);
+		if (testFixed(checkFixedEdges[i])) {
+			nSuccess++;
+		}
+		else {
+			nFail++;
+		}
+	}
+
 	printf("Success: %d  Fail: %d\n", nSuccess, nFail);
 	return nFail == 0;
 }
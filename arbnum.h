@@ -5,30 +5,193 @@
 #ifndef ARBNUM_H
 #define ARBNUM_H
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 class UnsignedDivide;
 class ArbNumDivide;
+class GcdMatrix;
+class Montgomery;
+
+// Where the heap limbs of Unsigned numbers come from.  Each thread allocates from its current()
+// allocator, standard() unless a LimbAllocatorScope says otherwise, and every buffer goes back
+// to the allocator it came from.  allocatorFor() lets an allocator pass requests it doesn't want
+// on to another one.
+class LimbAllocator {
+public:
+	virtual ~LimbAllocator() { }
+	virtual LimbAllocator &allocatorFor(const size_t) { return *this; }
+	virtual void *allocate(const size_t) = 0;
+	virtual void *reallocate(void *, const size_t, const size_t) = 0;
+	virtual void release(void *, const size_t) = 0;
+
+	static LimbAllocator &standard();	// malloc(), realloc() and free() behind per thread free lists
+	static LimbAllocator &current();
+};
 
-class Unsigned {
-	typedef std::vector<int> digits_t;
-	digits_t mDigits;
+// Makes an allocator current on this thread until the scope ends.  Threads doing parts of a
+// big multiplication still use standard().
+class LimbAllocatorScope {
+	LimbAllocator *mPrevious;
+
+public:
+	explicit LimbAllocatorScope(LimbAllocator &);
+	~LimbAllocatorScope();
+};
+
+// Bump allocation out of big blocks, for the temporaries of one computation.  Nothing is
+// freed until reset(), by which time every number using the arena must be gone; the blocks
+// are kept for next time.  Buffers over largest bytes, and everything once limit bytes of
+// blocks are in use, come from standard().  Only the thread that made the arena allocates
+// from it.
+class LimbArena : public LimbAllocator {
+	static const size_t BLOCK_BYTES = (size_t)1 << 20;
+
+	const size_t mLargest;
+	const size_t mMaxBlocks;
+	const std::thread::id mOwner;
+	std::vector<char *> mBlocks;
+	size_t mInUse;	// Blocks handed out since reset(), the last one is being carved up
+	char *mNext;
+	char *mEnd;
+
+	static size_t rounded(const size_t bytes) { return (bytes + 15) & ~(size_t)15; }
+	void nextBlock();
 
-	void zero();
-	void pad(const size_t wantedLength);
-	static void padShorterNumber(Unsigned &, Unsigned &);
-	static void padShorterNumber(const Unsigned *&pA, const Unsigned *&pB, Unsigned &padded);
-	void appendRight(const int digit, const size_t numberOfDigits);
+public:
+	explicit LimbArena(const size_t largest = (size_t)1 << 16, const size_t limit = (size_t)1 << 24);
+	~LimbArena();
+
+	LimbAllocator &allocatorFor(const size_t);
+	void *allocate(const size_t);
+	void *reallocate(void *, const size_t, const size_t);
+	void release(void *, const size_t);
+	void reset();
+};
+
+// Free lists of power of two buffers from 64 bytes to 64 KB, for numbers that live a while
+// and come and go in similar sizes.  Bigger buffers come from standard().  Safe to use from
+// several threads, and must outlive every number that used it.
+class LimbPool : public LimbAllocator {
+	static const int CLASSES = 11;
+	static const size_t SMALLEST = 64;
+
+	std::mutex mLock;
+	void *mFree[CLASSES];	// Each free buffer starts with a pointer to the next
+
+	static int sizeClass(const size_t);
+
+public:
+	LimbPool();
+	~LimbPool();
+
+	LimbAllocator &allocatorFor(const size_t);
+	void *allocate(const size_t);
+	void *reallocate(void *, const size_t, const size_t);
+	void release(void *, const size_t);
+};
+
+class Unsigned {
+public:
+	typedef uint32_t limb_t;	// One base 2^32 "digit"
+	typedef uint64_t dlimb_t;	// Holds limb * limb + limb + limb without overflow
+	static const int LIMB_BITS = 32;
+
+private:
+	friend class Montgomery;
+	template <int> friend class FixedUnsigned;
+
+	// Like std::vector<limb_t> but small numbers live inside the object and only larger ones go to the heap
+	class Limbs {
+		static const size_t INLINE_LIMBS = 4;	// Up to 128 bits without a heap allocation
+
+		limb_t *mData;	// Points at mInline or the heap
+		size_t mSize;
+		size_t mCapacity;
+		LimbAllocator *mAllocator;	// Where a heap mData came from
+		limb_t mInline[INLINE_LIMBS];
+
+		bool isInline() const { return mData == mInline; }
+		void grow(const size_t);
+
+	public:
+		Limbs() : mData(mInline), mSize(0), mCapacity(INLINE_LIMBS), mAllocator(NULL) { }
+		Limbs(const Limbs &);
+		Limbs(Limbs &&) noexcept;
+		~Limbs() { if (!isInline()) mAllocator->release(mData, mCapacity * sizeof(limb_t)); }
+		Limbs &operator=(const Limbs &);
+		Limbs &operator=(Limbs &&) noexcept;
+
+		size_t size() const { return mSize; }
+		bool empty() const { return mSize == 0; }
+		limb_t &operator[](const size_t i) { return mData[i]; }
+		const limb_t &operator[](const size_t i) const { return mData[i]; }
+		limb_t back() const { return mData[mSize - 1]; }
+		void pop_back() { mSize--; }
+		void push_back(const limb_t limb) { if (mSize == mCapacity) grow(mSize + 1); mData[mSize++] = limb; }
+		void clear() { mSize = 0; }
+		void reserve(const size_t n) { if (n > mCapacity) grow(n); }
+		void resize(const size_t, const limb_t);
+		void assign(const size_t, const limb_t);
+		void insertLow(const size_t);
+		void eraseLow(const size_t);
+	};
+
+	typedef Limbs limbs_t;
+	limbs_t mLimbs;	// Least significant limb first, no leading zero limbs
 
 	static int charToInt(const char);
 	static char intToChar(const int);
 
 	void mkError();
-	size_t length() const { return mDigits.size(); }
-	void prepend(const int digit) { mDigits.insert(mDigits.begin(), digit); }
-	void append(const int digit) { mDigits.push_back(digit); }
-	static Unsigned findDivisibleSizedChunk(const Unsigned &runningDividend, const Unsigned &dividend, const Unsigned &divisor, int &iDividendPos, bool &fits);
+	size_t length() const { return mLimbs.size(); }
+	void append(const limb_t limb) { mLimbs.push_back(limb); }
+	size_t bitLength() const;
+	bool testBit(const size_t) const;
+	void setBit(const size_t);
+	void shiftLeft(const size_t);
+	void shiftRight(const size_t);
+	void multiplyAddSmall(const limb_t, const limb_t);
+	limb_t divideSmall(const limb_t);
+	static Unsigned fromDecimalBasecase(const char *, const size_t);
+	static Unsigned fromDecimal(const char *, const size_t);
+	static void appendDecimalBasecase(std::string &, const Unsigned &, const size_t);
+	static void appendDecimal(std::string &, const Unsigned &, const size_t);
+	Unsigned slice(const size_t, const size_t) const;
+	void addShifted(const Unsigned &, const size_t);
+	static Unsigned shifted(const Unsigned &, const size_t);
+	static Unsigned scaled(const Unsigned &, const limb_t);
+	static Unsigned absDifference(const Unsigned &, const Unsigned &, bool &);
+	static void evenAndOdd(const Unsigned &, const Unsigned &, const bool, Unsigned &, Unsigned &);
+	static void evaluateToom3(const Unsigned &, const size_t, Unsigned *, bool *);
+	static void evaluateToom4(const Unsigned &, const size_t, Unsigned *, bool *);
+	static Unsigned multiplyUnbalanced(const Unsigned &, const Unsigned &);
+	static Unsigned multiplyToom3(const Unsigned &, const Unsigned &);
+	static Unsigned multiplyToom4(const Unsigned &, const Unsigned &);
+	static void divideBasecase(const Unsigned &, const Unsigned &, Unsigned &, Unsigned &);
+	static void divideRecursive(const Unsigned &, const Unsigned &, Unsigned &, Unsigned &);
+	limb_t bitsAt(const size_t) const;
+	static bool halfGcdLehmer(Unsigned &, Unsigned &, const Unsigned &, GcdMatrix &);
+	static bool halfGcdStep(Unsigned &, Unsigned &, const Unsigned &, GcdMatrix &);
+	static void halfGcdTop(Unsigned &, Unsigned &, const size_t, GcdMatrix &);
+	static void halfGcd(Unsigned &, Unsigned &, GcdMatrix &);
+	static Unsigned gcdWithCofactor(const Unsigned &, const Unsigned &, Unsigned *, bool *);
+	static int jacobi(long, const Unsigned &);
+	static bool isStrongProbablePrime(const Unsigned &, const Unsigned &);
+	static bool isStrongLucasProbablePrime(const Unsigned &);
+	static bool sieveSegment(const Unsigned &, const size_t, std::vector<char> &);
+	template <typename Visit> static void sieveRange(const Unsigned &, const Unsigned &, const Visit &);
+	static Unsigned product(const std::vector<limb_t> &, const size_t, const size_t);
+	static Unsigned lowBits(const Unsigned &, const size_t);
+	static Unsigned inversePowerOfTwo(const Unsigned &, const size_t);
+	template <typename Square, typename Multiply>
+	static Unsigned slidingWindowPower(const Unsigned &, const Unsigned &, const Unsigned &, const Square &, const Multiply &);
+	static Unsigned primePowerProduct(const std::vector<limb_t> &, const std::vector<limb_t> &);
 
 public:
 	void trim();
@@ -38,34 +201,62 @@ public:
 	int toInt() const;
 	long toLong() const;
 	long long toLongLong() const;
+	unsigned long long toULongLong() const;
+	void setULongLong(const unsigned long long);
 	void set(const Unsigned &);
+	void set(Unsigned &&);
+	size_t limbs() const { return length(); }
+	void reserve(const size_t limbs) { mLimbs.reserve(limbs); }
 	bool isZero() const;
 	bool isOne() const;
 	bool isTwo() const;
 	bool isOdd() const;
 	bool isEven() const;
 
-	inline static void addMutable(Unsigned &, Unsigned &);
+	inline static void addMutable(Unsigned &, const Unsigned &);
 	static Unsigned add(const Unsigned &, const Unsigned &);
 
-	inline static void subtractMutable(Unsigned &, Unsigned &);
+	inline static void subtractMutable(Unsigned &, const Unsigned &);
+	static void subtractFromMutable(Unsigned &, const Unsigned &);
+	static void addProductMutable(Unsigned &, const Unsigned &, const Unsigned &);
 	static Unsigned subtract(const Unsigned &, const Unsigned &);
 
 	static Unsigned multiply(const Unsigned &, const Unsigned &);
+	static Unsigned square(const Unsigned &);
 	static UnsignedDivide divideByOneWithRem(const Unsigned &);
 	static UnsignedDivide divideByTwoWithRem(const Unsigned &);
-	static UnsignedDivide divideWithRemSlow(const Unsigned &, const Unsigned &);
 	static UnsignedDivide divideWithRemFast(const Unsigned &, const Unsigned &);
+	static UnsignedDivide divideWithRemSmall(const Unsigned &, const limb_t);
+	static limb_t modSmall(const Unsigned &, const limb_t);
 	static Unsigned half(const Unsigned &);
 	static Unsigned divide(const Unsigned &, const Unsigned &);
 	static Unsigned mod(const Unsigned &, const Unsigned &);
 	static Unsigned pow(const Unsigned &, const Unsigned &);
 	static Unsigned gcd(const Unsigned &, const Unsigned &);
+	static Unsigned gcdExtended(const Unsigned &, const Unsigned &, Unsigned &, bool &);
 	static Unsigned sqrt(const Unsigned &);
+	static Unsigned sqrtRem(const Unsigned &, Unsigned &);
+	static bool isPerfectSquare(const Unsigned &);
+	static Unsigned root(const Unsigned &, const limb_t);
+	static bool isPerfectPower(const Unsigned &, const bool);
 	static Unsigned random(const Unsigned &);
+	static Unsigned powMod(const Unsigned &, const Unsigned &, const Unsigned &);
 	static Unsigned isPrime(const Unsigned &);
+	static Unsigned isProbablePrime(const Unsigned &, const int);
+	static std::vector<Unsigned> primes(const Unsigned &, const Unsigned &);
+	static Unsigned countPrimes(const Unsigned &, const Unsigned &);
+	static Unsigned nextPrime(const Unsigned &);
+	static Unsigned factorial(const limb_t);
+	static Unsigned doubleFactorial(const limb_t);
+	static Unsigned factorialRatio(const limb_t, const limb_t);
 	static int compare(const Unsigned &, const Unsigned &);
 
+	static void setThreads(const int);
+	static int getThreads();
+	static bool setKernels(const char *);
+	static const char *getKernels();
+	static std::vector<const char *> kernelChoices();
+
 	void add(const Unsigned &);
 	void subtract(const Unsigned &);
 	void multiply(const Unsigned &);
@@ -75,19 +266,22 @@ public:
 
 	Unsigned() { }
 	Unsigned(const Unsigned &);
+	Unsigned(Unsigned &&) noexcept;
 	Unsigned(const char *);
 	Unsigned(const int);
 	Unsigned(const long);
 	Unsigned(const long long);
 	Unsigned(const bool);
 
-	int &operator[](const int i) { return mDigits[i]; }
-	Unsigned operator+=(const Unsigned &other) { add(other); return *this; }
-	Unsigned operator-=(const Unsigned &other) { subtract(other); return *this; }
-	Unsigned operator*=(const Unsigned &other) { multiply(other); return *this; }
-	Unsigned operator/=(const Unsigned &other) { divide(other); return *this; }
-	Unsigned operator%=(const Unsigned &other) { mod(other); return *this; }
-	Unsigned operator^=(const Unsigned &other) { pow(other); return *this; }
+	Unsigned &operator=(const Unsigned &other) { set(other); return *this; }
+	Unsigned &operator=(Unsigned &&other) noexcept { mLimbs = std::move(other.mLimbs); return *this; }
+	limb_t &operator[](const int i) { return mLimbs[i]; }
+	Unsigned &operator+=(const Unsigned &other) { add(other); return *this; }
+	Unsigned &operator-=(const Unsigned &other) { subtract(other); return *this; }
+	Unsigned &operator*=(const Unsigned &other) { multiply(other); return *this; }
+	Unsigned &operator/=(const Unsigned &other) { divide(other); return *this; }
+	Unsigned &operator%=(const Unsigned &other) { mod(other); return *this; }
+	Unsigned &operator^=(const Unsigned &other) { pow(other); return *this; }
 	Unsigned operator++(int);
 	Unsigned operator--(int);
 };
@@ -104,16 +298,47 @@ public:
 inline bool operator<(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) < 0; }
 inline bool operator>(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) > 0; }
 inline bool operator==(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) == 0; }
+inline bool operator!=(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) != 0; }
 inline bool operator<=(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) <= 0; }
 inline bool operator>=(const Unsigned &a, const Unsigned &b) { return Unsigned::compare(a, b) >= 0; }
 inline Unsigned operator+(const Unsigned &a, const Unsigned &b) { return Unsigned::add(a, b); }
 inline Unsigned operator-(const Unsigned &a, const Unsigned &b) { return Unsigned::subtract(a, b); }
 inline Unsigned operator*(const Unsigned &a, const Unsigned &b) { return Unsigned::multiply(a, b); }
+// A temporary on the left is reused for the result, so a + b + c copies a only once
+inline Unsigned operator+(Unsigned &&a, const Unsigned &b) { a.add(b); return std::move(a); }
+inline Unsigned operator-(Unsigned &&a, const Unsigned &b) { a.subtract(b); return std::move(a); }
+inline Unsigned operator*(Unsigned &&a, const Unsigned &b) { a.multiply(b); return std::move(a); }
 inline Unsigned operator/(const Unsigned &a, const Unsigned &b) { return Unsigned::divide(a, b); }
 inline Unsigned operator%(const Unsigned &a, const Unsigned &b) { return Unsigned::mod(a, b); }
 inline Unsigned operator^(const Unsigned &a, const Unsigned &b) { return Unsigned::pow(a, b); }
 
+// Modular arithmetic for one odd modulus m without dividing by it.  mulMod() and sqrMod()
+// work on numbers in Montgomery form, a R mod m for R = 2^(32 n) with n the limbs in m.
+class Montgomery {
+	Unsigned mModulus;
+	size_t mLength;			// Limbs in mModulus
+	Unsigned::limb_t mInverse;	// -1 / mModulus mod 2^32
+	Unsigned mWideInverse;		// -1 / mModulus mod R, only for big moduli
+	Unsigned mOne;			// R mod mModulus, 1 in Montgomery form
+	Unsigned mRSquared;		// R^2 mod mModulus
+
+	Unsigned reduce(const Unsigned &) const;
+
+public:
+	explicit Montgomery(const Unsigned &);
+
+	const Unsigned &modulus() const { return mModulus; }
+	const Unsigned &one() const { return mOne; }
+	Unsigned toMontgomery(const Unsigned &) const;
+	Unsigned fromMontgomery(const Unsigned &) const;
+	Unsigned mulMod(const Unsigned &, const Unsigned &) const;
+	Unsigned sqrMod(const Unsigned &) const;
+	Unsigned powMod(const Unsigned &, const Unsigned &) const;
+};
+
 class ArbNum {
+	template <int> friend class FixedArbNum;
+
 	typedef enum { SPEC_NORMAL, SPEC_ERROR, SPEC_IGNORE } SpecialType;
 	SpecialType	mSpecial;
 	int 		mSign;	// -1 or 1
@@ -129,6 +354,9 @@ class ArbNum {
 	void mkNegative() { mSign = -1; }
 	void mkPositive() { mSign = 1; }
 	void flipSign() { mSign *= -1; }
+	void setLongLong(const long long);
+	void addSigned(const ArbNum &, const int);
+	void addProductSigned(const ArbNum &, const ArbNum &, const int);
 
 public:
 	void saveNumber(const char *);
@@ -143,7 +371,9 @@ public:
 
 	ArbNum() { clear(); }
 	ArbNum(const Unsigned &);
+	ArbNum(Unsigned &&);
 	ArbNum(const ArbNum &);
+	ArbNum(ArbNum &&) noexcept;
 	ArbNum(const char *);
 	ArbNum(const int);
 	ArbNum(const long);
@@ -155,6 +385,7 @@ public:
 	static ArbNum add(const ArbNum &, const ArbNum &);
 	static ArbNum subtract(const ArbNum &, const ArbNum &);
 	static ArbNum multiply(const ArbNum &, const ArbNum &);
+	static ArbNum multiplyMod(const ArbNum &, const ArbNum &, const ArbNum &);
 	static ArbNumDivide divideWithRem(const ArbNum &, const ArbNum &);
 	static ArbNum divide(const ArbNum &, const ArbNum &);
 	static ArbNum mod(const ArbNum &, const ArbNum &);
@@ -163,16 +394,32 @@ public:
 	static ArbNum doNot(const ArbNum &);
 	static ArbNum pow(const ArbNum &, const ArbNum &);
 	static ArbNum gcd(const ArbNum &, const ArbNum &);
+	static ArbNum gcdExtended(const ArbNum &, const ArbNum &, ArbNum &, ArbNum &);
+	static ArbNum modInverse(const ArbNum &, const ArbNum &);
+	static ArbNum powMod(const ArbNum &, const ArbNum &, const ArbNum &);
 	static ArbNum factorial(const ArbNum &);
+	static ArbNum doubleFactorial(const ArbNum &);
+	static ArbNum partialFactorial(const ArbNum &, const ArbNum &);
 	static ArbNum sqrt(const ArbNum &);
+	static ArbNum sqrtRem(const ArbNum &, ArbNum &);
+	static ArbNum isPerfectSquare(const ArbNum &);
+	static ArbNum root(const ArbNum &, const ArbNum &);
+	static ArbNum isPerfectPower(const ArbNum &);
 	static ArbNum random(const ArbNum &);
 	static ArbNum isPrime(const ArbNum &);
+	static ArbNum isProbablePrime(const ArbNum &, const ArbNum &);
+	static ArbNum nextPrime(const ArbNum &);
+	static ArbNum countPrimes(const ArbNum &, const ArbNum &);
 	static int compare(const ArbNum &, const ArbNum &);
 
 	void set(const ArbNum &);
+	void set(ArbNum &&);
 	void add(const ArbNum &);
 	void subtract(const ArbNum &);
 	void multiply(const ArbNum &);
+	void setProduct(const ArbNum &, const ArbNum &);
+	void addProduct(const ArbNum &, const ArbNum &);
+	void subtractProduct(const ArbNum &, const ArbNum &);
 	void divide(const ArbNum &);
 	void mod(const ArbNum &);
 	void pow(const ArbNum &);
@@ -181,13 +428,17 @@ public:
 	int toInt() const;
 	long toLong() const;
 	long long toLongLong() const;
-
-	ArbNum operator+=(const ArbNum &other) { add(other); return *this; }
-	ArbNum operator-=(const ArbNum &other) { subtract(other); return *this; }
-	ArbNum operator*=(const ArbNum &other) { multiply(other); return *this; }
-	ArbNum operator/=(const ArbNum &other) { divide(other); return *this; }
-	ArbNum operator%=(const ArbNum &other) { mod(other); return *this; }
-	ArbNum operator^=(const ArbNum &other) { pow(other); return *this; }
+	size_t limbs() const { return mUnsigned.limbs(); }
+	void reserve(const size_t limbs) { mUnsigned.reserve(limbs); }
+
+	ArbNum &operator=(const ArbNum &other) { set(other); return *this; }
+	ArbNum &operator=(ArbNum &&other) noexcept { set(std::move(other)); return *this; }
+	ArbNum &operator+=(const ArbNum &other) { add(other); return *this; }
+	ArbNum &operator-=(const ArbNum &other) { subtract(other); return *this; }
+	ArbNum &operator*=(const ArbNum &other) { multiply(other); return *this; }
+	ArbNum &operator/=(const ArbNum &other) { divide(other); return *this; }
+	ArbNum &operator%=(const ArbNum &other) { mod(other); return *this; }
+	ArbNum &operator^=(const ArbNum &other) { pow(other); return *this; }
 	ArbNum operator++(int);
 	ArbNum operator--(int);
 
@@ -200,6 +451,11 @@ public:
 	static bool testAdd(const long, const long);
 	static bool testSubtract(const long, const long);
 	static bool testMultiply(const long, const long);
+	static bool testCompound(const long, const long);
+	static bool testExpression(const long, const long);
+	static bool testBigExpression(const long);
+	static bool testAllocator(const long);
+	static bool testScratch(const long);
 	static bool testDivide(const long, const long);
 	static bool testMod(const long, const long);
 	static bool testPow(const long, const long);
@@ -211,6 +467,28 @@ public:
 	static bool testIsPrime(const long);
 	static long factorialLong(const long);
 	static bool testFactorial(const long);
+	static bool testBigFactorial(const long);
+	static bool testPow(const char *, const long);
+	static bool testPowerOfTen(const long);
+	static bool testPowMod(const long, const long);
+	static bool testFermat(const long);
+	static bool testBigSqrt(const long);
+	static bool testBigRoot(const long);
+	static bool testBigStore(const char *);
+	static bool testBigDecimal(const long);
+	static bool testBigArithmetic(const char *, const char *);
+	static ArbNum powerOfTenBySaving(const long);
+	static bool testBigMultiply(const long, const long);
+	static bool testBigDivide(const long, const long);
+	static bool testDivideSmall(const long, const Unsigned::limb_t);
+	static bool testBigGcd(const long, const long);
+	static bool testMersennePrime(const long, const bool);
+	static bool testPseudoprime(const char *);
+	static bool testPrimeCount(const char *, const char *, const long);
+	static bool testNextPrime(const char *, const char *);
+	static bool testThreads(const long, const long);
+	static bool testKernels(const long);
+	static bool testFixed(const long);
 	static bool testAll();
 };
 
@@ -225,11 +503,15 @@ public:
 inline bool operator<(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) < 0; }
 inline bool operator>(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) > 0; }
 inline bool operator==(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) == 0; }
+inline bool operator!=(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) != 0; }
 inline bool operator<=(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) <= 0; }
 inline bool operator>=(const ArbNum &a, const ArbNum &b) { return ArbNum::compare(a, b) >= 0; }
 inline ArbNum operator+(const ArbNum &a, const ArbNum &b) { return ArbNum::add(a, b); }
 inline ArbNum operator-(const ArbNum &a, const ArbNum &b) { return ArbNum::subtract(a, b); }
 inline ArbNum operator*(const ArbNum &a, const ArbNum &b) { return ArbNum::multiply(a, b); }
+inline ArbNum operator+(ArbNum &&a, const ArbNum &b) { a.add(b); return std::move(a); }
+inline ArbNum operator-(ArbNum &&a, const ArbNum &b) { a.subtract(b); return std::move(a); }
+inline ArbNum operator*(ArbNum &&a, const ArbNum &b) { a.multiply(b); return std::move(a); }
 inline ArbNum operator/(const ArbNum &a, const ArbNum &b) { return ArbNum::divide(a, b); }
 inline ArbNum operator%(const ArbNum &a, const ArbNum &b) { return ArbNum::mod(a, b); }
 inline ArbNum operator^(const ArbNum &a, const ArbNum &b) { return ArbNum::pow(a, b); }
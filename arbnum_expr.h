@@ -0,0 +1,235 @@
+// A simple arbitrary precision library and interactive text program
+// Copyright © 2020, Dave McKellar
+// Mozilla Public Licensed
+
+// Lazy ArbNum arithmetic for long formulas.  Wrapping one operand in lazy() makes +, -, * and %
+// build a tree of nodes instead of a temporary per operator, and the tree is only worked out
+// when it's assigned:
+//
+//	ArbNum r = lazy(a) + lazy(b) * c;	// One allocation, b * c is added into r as it goes
+//	assign(r, lazy(a) * b % m);		// Reuses r's limbs, a * b is reduced without an ArbNum
+//
+// Products are fused into ArbNum::setProduct(), addProduct() and subtractProduct(), a product
+// mod m into ArbNum::multiplyMod(), and the destination is sized once up front.
+// Nodes keep references to their operands, so an expression must be assigned in the statement
+// that builds it.
+
+#ifndef ARBNUM_EXPR_H
+#define ARBNUM_EXPR_H
+
+#include <algorithm>
+#include "arbnum.h"
+
+template <typename Derived>
+class ArbNumExpression {
+public:
+	const Derived &derived() const { return static_cast<const Derived &>(*this); }
+
+	// dest += this and dest -= this, through a temporary unless the node can do better
+	void addTo(ArbNum &dest) const {
+		ArbNum value;
+		derived().evaluateInto(value);
+		dest.add(value);
+	}
+	void subtractFrom(ArbNum &dest) const {
+		ArbNum value;
+		derived().evaluateInto(value);
+		dest.subtract(value);
+	}
+
+	operator ArbNum() const {
+		ArbNum result;
+		result.reserve(derived().limbs());
+		derived().evaluateInto(result);
+		return result;
+	}
+};
+
+class ArbNumLeaf : public ArbNumExpression<ArbNumLeaf> {
+	const ArbNum &mValue;
+
+public:
+	explicit ArbNumLeaf(const ArbNum &value) : mValue(value) { }
+
+	const ArbNum &value() const { return mValue; }
+	size_t limbs() const { return mValue.limbs(); }
+	bool uses(const ArbNum *a) const { return &mValue == a; }
+	void evaluateInto(ArbNum &dest) const { dest = mValue; }
+	void addTo(ArbNum &dest) const { dest.add(mValue); }
+	void subtractFrom(ArbNum &dest) const { dest.subtract(mValue); }
+};
+
+// The value of an operand: a leaf's own ArbNum, anything else worked out into a temporary
+template <typename E>
+class ArbNumOperand {
+	ArbNum mValue;
+
+public:
+	explicit ArbNumOperand(const E &e) { mValue.reserve(e.limbs()); e.evaluateInto(mValue); }
+	const ArbNum &value() const { return mValue; }
+};
+
+template <>
+class ArbNumOperand<ArbNumLeaf> {
+	const ArbNum &mValue;
+
+public:
+	explicit ArbNumOperand(const ArbNumLeaf &e) : mValue(e.value()) { }
+	const ArbNum &value() const { return mValue; }
+};
+
+template <typename L, typename R>
+class ArbNumSum : public ArbNumExpression<ArbNumSum<L, R> > {
+	const L mLeft;
+	const R mRight;
+
+public:
+	ArbNumSum(const L &left, const R &right) : mLeft(left), mRight(right) { }
+
+	size_t limbs() const { return std::max(mLeft.limbs(), mRight.limbs()) + 1; }
+	bool uses(const ArbNum *a) const { return mLeft.uses(a) || mRight.uses(a); }
+	void evaluateInto(ArbNum &dest) const { mLeft.evaluateInto(dest); mRight.addTo(dest); }
+	void addTo(ArbNum &dest) const { mLeft.addTo(dest); mRight.addTo(dest); }
+	void subtractFrom(ArbNum &dest) const { mLeft.subtractFrom(dest); mRight.subtractFrom(dest); }
+};
+
+template <typename L, typename R>
+class ArbNumDifference : public ArbNumExpression<ArbNumDifference<L, R> > {
+	const L mLeft;
+	const R mRight;
+
+public:
+	ArbNumDifference(const L &left, const R &right) : mLeft(left), mRight(right) { }
+
+	size_t limbs() const { return std::max(mLeft.limbs(), mRight.limbs()) + 1; }
+	bool uses(const ArbNum *a) const { return mLeft.uses(a) || mRight.uses(a); }
+	void evaluateInto(ArbNum &dest) const { mLeft.evaluateInto(dest); mRight.subtractFrom(dest); }
+	void addTo(ArbNum &dest) const { mLeft.addTo(dest); mRight.subtractFrom(dest); }
+	void subtractFrom(ArbNum &dest) const { mLeft.subtractFrom(dest); mRight.addTo(dest); }
+};
+
+template <typename L, typename R>
+class ArbNumProduct : public ArbNumExpression<ArbNumProduct<L, R> > {
+	const L mLeft;
+	const R mRight;
+
+public:
+	ArbNumProduct(const L &left, const R &right) : mLeft(left), mRight(right) { }
+
+	const L &left() const { return mLeft; }
+	const R &right() const { return mRight; }
+	size_t limbs() const { return mLeft.limbs() + mRight.limbs(); }
+	bool uses(const ArbNum *a) const { return mLeft.uses(a) || mRight.uses(a); }
+	void evaluateInto(ArbNum &dest) const {
+		const ArbNumOperand<L> left(mLeft);
+		const ArbNumOperand<R> right(mRight);
+		dest.setProduct(left.value(), right.value());
+	}
+	void addTo(ArbNum &dest) const {
+		const ArbNumOperand<L> left(mLeft);
+		const ArbNumOperand<R> right(mRight);
+		dest.addProduct(left.value(), right.value());
+	}
+	void subtractFrom(ArbNum &dest) const {
+		const ArbNumOperand<L> left(mLeft);
+		const ArbNumOperand<R> right(mRight);
+		dest.subtractProduct(left.value(), right.value());
+	}
+};
+
+template <typename L, typename R>
+class ArbNumRemainder : public ArbNumExpression<ArbNumRemainder<L, R> > {
+	const L mLeft;
+	const R mRight;
+
+	// a * b % m
+	template <typename A, typename B>
+	static void evaluate(ArbNum &dest, const ArbNumProduct<A, B> &left, const R &right) {
+		const ArbNumOperand<A> a(left.left());
+		const ArbNumOperand<B> b(left.right());
+		const ArbNumOperand<R> m(right);
+		dest = ArbNum::multiplyMod(a.value(), b.value(), m.value());
+	}
+
+	template <typename E>
+	static void evaluate(ArbNum &dest, const E &left, const R &right) {
+		const ArbNumOperand<E> a(left);
+		const ArbNumOperand<R> m(right);
+		dest = ArbNum::mod(a.value(), m.value());
+	}
+
+public:
+	ArbNumRemainder(const L &left, const R &right) : mLeft(left), mRight(right) { }
+
+	size_t limbs() const { return mRight.limbs(); }
+	bool uses(const ArbNum *a) const { return mLeft.uses(a) || mRight.uses(a); }
+	void evaluateInto(ArbNum &dest) const { evaluate(dest, mLeft, mRight); }
+};
+
+inline ArbNumLeaf lazy(const ArbNum &a) { return ArbNumLeaf(a); }
+
+// Works e out into dest.  An e that reads dest is worked out on the side first.
+template <typename E>
+ArbNum &assign(ArbNum &dest, const ArbNumExpression<E> &e) {
+	if (e.derived().uses(&dest)) {
+		dest = ArbNum(e);
+		return dest;
+	}
+	dest.reserve(e.derived().limbs());
+	e.derived().evaluateInto(dest);
+	return dest;
+}
+
+template <typename L, typename R>
+ArbNumSum<L, R> operator+(const ArbNumExpression<L> &a, const ArbNumExpression<R> &b) {
+	return ArbNumSum<L, R>(a.derived(), b.derived());
+}
+template <typename L>
+ArbNumSum<L, ArbNumLeaf> operator+(const ArbNumExpression<L> &a, const ArbNum &b) {
+	return ArbNumSum<L, ArbNumLeaf>(a.derived(), ArbNumLeaf(b));
+}
+template <typename R>
+ArbNumSum<ArbNumLeaf, R> operator+(const ArbNum &a, const ArbNumExpression<R> &b) {
+	return ArbNumSum<ArbNumLeaf, R>(ArbNumLeaf(a), b.derived());
+}
+
+template <typename L, typename R>
+ArbNumDifference<L, R> operator-(const ArbNumExpression<L> &a, const ArbNumExpression<R> &b) {
+	return ArbNumDifference<L, R>(a.derived(), b.derived());
+}
+template <typename L>
+ArbNumDifference<L, ArbNumLeaf> operator-(const ArbNumExpression<L> &a, const ArbNum &b) {
+	return ArbNumDifference<L, ArbNumLeaf>(a.derived(), ArbNumLeaf(b));
+}
+template <typename R>
+ArbNumDifference<ArbNumLeaf, R> operator-(const ArbNum &a, const ArbNumExpression<R> &b) {
+	return ArbNumDifference<ArbNumLeaf, R>(ArbNumLeaf(a), b.derived());
+}
+
+template <typename L, typename R>
+ArbNumProduct<L, R> operator*(const ArbNumExpression<L> &a, const ArbNumExpression<R> &b) {
+	return ArbNumProduct<L, R>(a.derived(), b.derived());
+}
+template <typename L>
+ArbNumProduct<L, ArbNumLeaf> operator*(const ArbNumExpression<L> &a, const ArbNum &b) {
+	return ArbNumProduct<L, ArbNumLeaf>(a.derived(), ArbNumLeaf(b));
+}
+template <typename R>
+ArbNumProduct<ArbNumLeaf, R> operator*(const ArbNum &a, const ArbNumExpression<R> &b) {
+	return ArbNumProduct<ArbNumLeaf, R>(ArbNumLeaf(a), b.derived());
+}
+
+template <typename L, typename R>
+ArbNumRemainder<L, R> operator%(const ArbNumExpression<L> &a, const ArbNumExpression<R> &b) {
+	return ArbNumRemainder<L, R>(a.derived(), b.derived());
+}
+template <typename L>
+ArbNumRemainder<L, ArbNumLeaf> operator%(const ArbNumExpression<L> &a, const ArbNum &b) {
+	return ArbNumRemainder<L, ArbNumLeaf>(a.derived(), ArbNumLeaf(b));
+}
+template <typename R>
+ArbNumRemainder<ArbNumLeaf, R> operator%(const ArbNum &a, const ArbNumExpression<R> &b) {
+	return ArbNumRemainder<ArbNumLeaf, R>(ArbNumLeaf(a), b.derived());
+}
+
+#endif
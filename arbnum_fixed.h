@@ -0,0 +1,1047 @@
+// A simple arbitrary precision library and interactive text program
+// Copyright © 2020, Dave McKellar
+// Mozilla Public Licensed
+
+// Fixed width versions of Unsigned and ArbNum for numbers that are always about the same size:
+//
+//	FixedUnsigned<256> a("123456789012345678901234567890"), b = 7;
+//	FixedUnsigned<256> c = a * b % FixedUnsigned<256>(1000003);
+//	ArbNum big(FixedArbNum<256>(c));		// Back to the growing kind
+//
+// The limbs are a std::array inside the object, so nothing is allocated, apart from random()
+// and countPrimes() which go through Unsigned.  The loops over every limb, adding,
+// subtracting, multiplying, comparing and copying, have #pragma GCC unroll so they are
+// written out limb by limb up to 64 limbs, which suits widths of a few hundred bits.
+// Division, powers and roots loop over as many limbs or bits as the numbers have.
+// Bits must be a multiple of 64.
+// Results keep their low Bits bits like built in unsigned types, so a - b with b > a wraps.
+// A FixedArbNum is a sign and a FixedUnsigned like ArbNum is a sign and an Unsigned.
+// Converting from Unsigned or ArbNum keeps the low Bits bits.
+
+#ifndef ARBNUM_FIXED_H
+#define ARBNUM_FIXED_H
+
+#include <stdio.h>
+#include <array>
+#include <string>
+#include <utility>
+#include "arbnum.h"
+
+// 0, 1 ... N - 1 as a parameter pack, for building all the limbs in a constexpr constructor
+template <int...> struct FixedIndices { };
+template <int N, int... Is> struct MakeFixedIndices : MakeFixedIndices<N - 1, N - 1, Is...> { };
+template <int... Is> struct MakeFixedIndices<0, Is...> : FixedIndices<Is...> { };
+
+template <int Bits>
+class FixedUnsigned {
+	static_assert(Bits > 0 && Bits % 64 == 0, "FixedUnsigned needs a multiple of 64 bits");
+
+public:
+	typedef Unsigned::limb_t limb_t;
+	typedef Unsigned::dlimb_t dlimb_t;
+	static const int LIMB_BITS = Unsigned::LIMB_BITS;
+	static const int LIMBS = Bits / LIMB_BITS;
+
+private:
+	template <int> friend class FixedUnsigned;
+	template <int> friend class FixedArbNum;
+
+	std::array<limb_t, LIMBS> mLimbs;	// Least significant limb first, leading zeros and all
+
+	// Limbs without the leading zero ones
+	int length() const {
+		int n = LIMBS;
+		while (n > 0 && mLimbs[n - 1] == 0) {
+			n--;
+		}
+		return n;
+	}
+
+	int bitLength() const {
+		const int n = length();
+		if (n == 0) return 0;
+		int bits = (n - 1) * LIMB_BITS;
+		for (limb_t top = mLimbs[n - 1]; top != 0; top >>= 1) {
+			bits++;
+		}
+		return bits;
+	}
+
+	bool testBit(const int bit) const { return (mLimbs[bit / LIMB_BITS] >> (bit % LIMB_BITS)) & 1; }
+	void setBit(const int bit) { mLimbs[bit / LIMB_BITS] |= (limb_t)1 << (bit % LIMB_BITS); }
+
+	// a * b mod m through a product twice as wide
+	static FixedUnsigned mulMod(const FixedUnsigned &a, const FixedUnsigned &b, const FixedUnsigned &m) {
+		const FixedUnsigned<2 * Bits> product = multiplyFull(a, b);
+		return FixedUnsigned(FixedUnsigned<2 * Bits>::mod(product, FixedUnsigned<2 * Bits>(m)));
+	}
+
+	// Limb i of value, sign extended into the limbs above it when negative
+	static constexpr limb_t limbOf(const unsigned long long value, const bool negative, const int i) {
+		return i == 0 ? (limb_t)value : i == 1 ? (limb_t)(value >> 32) : negative ? ~(limb_t)0 : 0;
+	}
+
+	template <int... Is>
+	constexpr FixedUnsigned(const unsigned long long value, const bool negative, FixedIndices<Is...>)
+		: mLimbs{ { limbOf(value, negative, Is)... } } { }
+
+	// x^n, or false when that is more than cap
+	static bool powAtMost(const FixedUnsigned &x, const limb_t n, const FixedUnsigned &cap, FixedUnsigned &result) {
+		const FixedUnsigned<2 * Bits> wideCap(cap);
+		result = FixedUnsigned(1);
+		for (limb_t i = 0; i < n; i++) {
+			const FixedUnsigned<2 * Bits> product = multiplyFull(result, x);
+			if (product > wideCap) return false;
+			result = FixedUnsigned(product);
+		}
+		return true;
+	}
+
+	// a is a strong probable prime to base, with a - 1 = d * 2^s and d odd
+	static bool isStrongProbablePrime(const FixedUnsigned &a, const FixedUnsigned &d, const int s, const FixedUnsigned &base) {
+		const FixedUnsigned minusOne = subtract(a, FixedUnsigned(1));
+		FixedUnsigned x = powMod(base, d, a);
+		if (x.isOne() || x == minusOne) return true;
+		for (int i = 1; i < s; i++) {
+			x = mulMod(x, x, a);
+			if (x == minusOne) return true;
+			if (x.isOne()) return false;
+		}
+		return false;
+	}
+
+	// x + y mod m for x, y < m, without going past 2^Bits
+	static FixedUnsigned addMod(const FixedUnsigned &x, const FixedUnsigned &y, const FixedUnsigned &m) {
+		const FixedUnsigned rest = subtract(m, y);
+		return compare(x, rest) >= 0 ? subtract(x, rest) : add(x, y);
+	}
+
+	// x / 2 mod odd m for x < m
+	static FixedUnsigned halfMod(const FixedUnsigned &x, const FixedUnsigned &m) {
+		const FixedUnsigned half = divide(x, FixedUnsigned(2));
+		return x.isOdd() ? add(add(half, divide(m, FixedUnsigned(2))), FixedUnsigned(1)) : half;
+	}
+
+	// Jacobi symbol (d / n) for odd n, like Unsigned::jacobi()
+	static int jacobi(long d, const FixedUnsigned &n) {
+		int result = 1;
+		const limb_t nMod8 = n.mLimbs[0] % 8;
+
+		if (d < 0) {
+			d = -d;
+			if (nMod8 % 4 == 3) result = -result;
+		}
+		while (d != 0 && d % 2 == 0) {
+			d /= 2;
+			if (nMod8 == 3 || nMod8 == 5) result = -result;
+		}
+		if (d % 4 == 3 && nMod8 % 4 == 3) result = -result;
+
+		// (n mod d / d) for odd d
+		unsigned long long a = mod(n, FixedUnsigned((unsigned long long)d)).mLimbs[0];
+		unsigned long long m = (unsigned long long)d;
+		while (a != 0) {
+			while ((a & 1) == 0) {
+				a /= 2;
+				if (m % 8 == 3 || m % 8 == 5) result = -result;
+			}
+			std::swap(a, m);
+			if (a % 4 == 3 && m % 4 == 3) result = -result;
+			a %= m;
+		}
+		return m == 1 ? result : 0;
+	}
+
+	// Strong Lucas probable prime for odd n, not a square, with Selfridge's parameters, the same
+	// steps as Unsigned::isStrongLucasProbablePrime() with every sum kept below n
+	static bool isStrongLucasProbablePrime(const FixedUnsigned &n) {
+		long d = 5;
+		for (;;) {
+			const int j = jacobi(d, n);
+			if (j == -1) break;
+			if (j == 0 && n > FixedUnsigned((unsigned long long)(d < 0 ? -d : d))) return false;	// |d| is a factor
+			d = d > 0 ? -(d + 2) : -d + 2;
+		}
+		const long q = (1 - d) / 4;
+
+		// D and Q as residues mod n
+		FixedUnsigned dMod((unsigned long long)(d < 0 ? -d : d));
+		if (d < 0) dMod = subtract(n, dMod);
+		FixedUnsigned qMod((unsigned long long)(q < 0 ? -q : q));
+		if (q < 0) qMod = subtract(n, qMod);
+
+		// n + 1 = k 2^s, k odd.  n is odd and below 2^Bits, so k 2^(s-1) = (n - 1) / 2 + 1.
+		FixedUnsigned k = add(divide(n, FixedUnsigned(2)), FixedUnsigned(1));
+		int s = 1;
+		while (k.isEven()) {
+			k = divide(k, FixedUnsigned(2));
+			s++;
+		}
+
+		// V^2 - 2 Q^j mod n
+		auto nextV = [&n](const FixedUnsigned &v, const FixedUnsigned &qk) {
+			const FixedUnsigned minusQk = qk.isZero() ? qk : subtract(n, qk);
+			return addMod(mulMod(v, v, n), addMod(minusQk, minusQk, n), n);
+		};
+
+		FixedUnsigned u(1), v(1), qk(qMod);
+		for (int bit = k.bitLength() - 1; bit-- > 0;) {
+			u = mulMod(u, v, n);
+			v = nextV(v, qk);
+			qk = mulMod(qk, qk, n);
+			if (k.testBit(bit)) {
+				const FixedUnsigned newU = halfMod(addMod(u, v, n), n);
+				v = halfMod(addMod(mulMod(dMod, u, n), v, n), n);
+				u = newU;
+				qk = mulMod(qk, qMod, n);
+			}
+		}
+
+		if (u.isZero() || v.isZero()) return true;
+
+		for (int r = 1; r < s; r++) {
+			v = nextV(v, qk);
+			qk = mulMod(qk, qk, n);
+			if (v.isZero()) return true;
+		}
+		return false;
+	}
+
+public:
+	constexpr FixedUnsigned() : mLimbs() { }
+	constexpr FixedUnsigned(const unsigned long long value) : FixedUnsigned(value, false, MakeFixedIndices<LIMBS>()) { }
+	// Negative values wrap like unsigned types, so -1 is 2^Bits - 1
+	constexpr FixedUnsigned(const int value)
+		: FixedUnsigned((unsigned long long)(long long)value, value < 0, MakeFixedIndices<LIMBS>()) { }
+	FixedUnsigned(const char *s) : FixedUnsigned(Unsigned(s)) { }
+
+	// The low Bits bits of a
+	explicit FixedUnsigned(const Unsigned &a) : mLimbs() {
+		const int n = a.length() < (size_t)LIMBS ? (int)a.length() : LIMBS;
+		for (int i = 0; i < n; i++) {
+			mLimbs[i] = a.mLimbs[i];
+		}
+	}
+
+	// Zero extends a narrower number or keeps the low Bits bits of a wider one
+	template <int OtherBits>
+	explicit FixedUnsigned(const FixedUnsigned<OtherBits> &a) : mLimbs() {
+		const int n = FixedUnsigned<OtherBits>::LIMBS < LIMBS ? FixedUnsigned<OtherBits>::LIMBS : LIMBS;
+#pragma GCC unroll 64
+		for (int i = 0; i < n; i++) {
+			mLimbs[i] = a.mLimbs[i];
+		}
+	}
+
+	explicit operator Unsigned() const {
+		Unsigned result;
+		const int n = length();
+		result.mLimbs.resize(n, 0);
+		for (int i = 0; i < n; i++) {
+			result.mLimbs[i] = mLimbs[i];
+		}
+		return result;
+	}
+
+	std::string toString() const { return Unsigned(*this).toString(); }
+	int toInt() const { return (int)mLimbs[0]; }
+	long toLong() const { return (long)toULongLong(); }
+	long long toLongLong() const { return (long long)toULongLong(); }
+	unsigned long long toULongLong() const { return (unsigned long long)mLimbs[1] << 32 | mLimbs[0]; }
+	void setULongLong(const unsigned long long value) { *this = FixedUnsigned(value); }
+	size_t limbs() const { return length(); }
+
+	bool isZero() const {
+		limb_t bits = 0;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			bits |= mLimbs[i];
+		}
+		return bits == 0;
+	}
+	bool isOne() const { return mLimbs[0] == 1 && length() == 1; }
+	bool isTwo() const { return mLimbs[0] == 2 && length() == 1; }
+	bool isOdd() const { return (mLimbs[0] & 1) != 0; }
+	bool isEven() const { return (mLimbs[0] & 1) == 0; }
+
+	// From the bottom up, so the highest limb that differs decides
+	static int compare(const FixedUnsigned &a, const FixedUnsigned &b) {
+		int order = 0;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			if (a.mLimbs[i] != b.mLimbs[i]) order = a.mLimbs[i] < b.mLimbs[i] ? -1 : 1;
+		}
+		return order;
+	}
+
+	void add(const FixedUnsigned &other) {
+		dlimb_t carry = 0;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			const dlimb_t sum = (dlimb_t)mLimbs[i] + other.mLimbs[i] + carry;
+			mLimbs[i] = (limb_t)sum;
+			carry = sum >> LIMB_BITS;
+		}
+	}
+
+	void subtract(const FixedUnsigned &other) {
+		limb_t borrow = 0;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			const dlimb_t diff = (dlimb_t)mLimbs[i] - other.mLimbs[i] - borrow;
+			mLimbs[i] = (limb_t)diff;
+			borrow = (limb_t)(diff >> LIMB_BITS) & 1;
+		}
+	}
+
+	static FixedUnsigned add(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned result(a);
+		result.add(b);
+		return result;
+	}
+
+	static FixedUnsigned subtract(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned result(a);
+		result.subtract(b);
+		return result;
+	}
+
+	// The low Bits bits of a * b.  The inner loop runs LIMBS times too so both unroll, and
+	// the products past the top limb are dropped by a test on constants.
+	static FixedUnsigned multiply(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned result;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			dlimb_t carry = 0;
+#pragma GCC unroll 64
+			for (int j = 0; j < LIMBS; j++) {
+				if (i + j < LIMBS) {
+					const dlimb_t t = (dlimb_t)a.mLimbs[j] * b.mLimbs[i] + result.mLimbs[i + j] + carry;
+					result.mLimbs[i + j] = (limb_t)t;
+					carry = t >> LIMB_BITS;
+				}
+			}
+		}
+		return result;
+	}
+
+	// All of a * b
+	static FixedUnsigned<2 * Bits> multiplyFull(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned<2 * Bits> result;
+#pragma GCC unroll 64
+		for (int i = 0; i < LIMBS; i++) {
+			dlimb_t carry = 0;
+#pragma GCC unroll 64
+			for (int j = 0; j < LIMBS; j++) {
+				const dlimb_t t = (dlimb_t)a.mLimbs[j] * b.mLimbs[i] + result.mLimbs[i + j] + carry;
+				result.mLimbs[i + j] = (limb_t)t;
+				carry = t >> LIMB_BITS;
+			}
+			result.mLimbs[i + LIMBS] = (limb_t)carry;
+		}
+		return result;
+	}
+
+	static FixedUnsigned square(const FixedUnsigned &a) { return multiply(a, a); }
+
+	// Knuth's algorithm D.  Returns a / b and sets remainder to a % b.
+	static FixedUnsigned divideWithRem(const FixedUnsigned &a, const FixedUnsigned &b, FixedUnsigned &remainder) {
+		FixedUnsigned quotient;
+		const int an = a.length();
+		const int bn = b.length();
+		if (bn == 0) {
+			fprintf(stderr, "Division by zero\n");
+			remainder = FixedUnsigned();
+			return quotient;
+		}
+		if (an < bn) {
+			remainder = a;
+			return quotient;
+		}
+
+		if (bn == 1) {
+			const limb_t divisor = b.mLimbs[0];
+			dlimb_t rem = 0;
+			for (int i = an - 1; i >= 0; i--) {
+				const dlimb_t t = rem << LIMB_BITS | a.mLimbs[i];
+				quotient.mLimbs[i] = (limb_t)(t / divisor);
+				rem = t % divisor;
+			}
+			remainder = FixedUnsigned((unsigned long long)rem);
+			return quotient;
+		}
+
+		// Shift both so the top bit of the divisor is set
+		int shift = 0;
+		for (limb_t top = b.mLimbs[bn - 1]; (top & 0x80000000) == 0; top <<= 1) {
+			shift++;
+		}
+		limb_t u[LIMBS + 1];
+		limb_t v[LIMBS];
+		u[an] = (limb_t)((dlimb_t)a.mLimbs[an - 1] >> (LIMB_BITS - shift));
+		for (int i = an - 1; i > 0; i--) {
+			u[i] = (limb_t)(((dlimb_t)a.mLimbs[i] << LIMB_BITS | a.mLimbs[i - 1]) >> (LIMB_BITS - shift));
+		}
+		u[0] = a.mLimbs[0] << shift;
+		for (int i = bn - 1; i > 0; i--) {
+			v[i] = (limb_t)(((dlimb_t)b.mLimbs[i] << LIMB_BITS | b.mLimbs[i - 1]) >> (LIMB_BITS - shift));
+		}
+		v[0] = b.mLimbs[0] << shift;
+
+		for (int j = an - bn; j >= 0; j--) {
+			// Guess from the top two limbs, at most one too big after the correction
+			const dlimb_t top = (dlimb_t)u[j + bn] << LIMB_BITS | u[j + bn - 1];
+			dlimb_t qhat = top / v[bn - 1];
+			dlimb_t rhat = top % v[bn - 1];
+			while ((qhat >> LIMB_BITS) != 0 || qhat * v[bn - 2] > (rhat << LIMB_BITS | u[j + bn - 2])) {
+				qhat--;
+				rhat += v[bn - 1];
+				if ((rhat >> LIMB_BITS) != 0) break;
+			}
+
+			// u -= qhat * v
+			dlimb_t carry = 0;
+			limb_t borrow = 0;
+			for (int i = 0; i < bn; i++) {
+				const dlimb_t product = qhat * v[i] + carry;
+				carry = product >> LIMB_BITS;
+				const dlimb_t diff = (dlimb_t)u[i + j] - (limb_t)product - borrow;
+				u[i + j] = (limb_t)diff;
+				borrow = (limb_t)(diff >> LIMB_BITS) & 1;
+			}
+			const dlimb_t diff = (dlimb_t)u[j + bn] - carry - borrow;
+			u[j + bn] = (limb_t)diff;
+
+			// One too many, add v back
+			if ((diff >> (2 * LIMB_BITS - 1)) != 0) {
+				qhat--;
+				carry = 0;
+				for (int i = 0; i < bn; i++) {
+					const dlimb_t sum = (dlimb_t)u[i + j] + v[i] + carry;
+					u[i + j] = (limb_t)sum;
+					carry = sum >> LIMB_BITS;
+				}
+				u[j + bn] += (limb_t)carry;
+			}
+			quotient.mLimbs[j] = (limb_t)qhat;
+		}
+
+		// The remainder is the low bn limbs of u shifted back
+		FixedUnsigned rem;
+		for (int i = 0; i < bn; i++) {
+			rem.mLimbs[i] = (limb_t)(((dlimb_t)u[i + 1] << LIMB_BITS | u[i]) >> shift);
+		}
+		remainder = rem;
+		return quotient;
+	}
+
+	static FixedUnsigned divide(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned remainder;
+		return divideWithRem(a, b, remainder);
+	}
+
+	static FixedUnsigned mod(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned remainder;
+		divideWithRem(a, b, remainder);
+		return remainder;
+	}
+
+	// The low Bits bits of a^n
+	static FixedUnsigned pow(const FixedUnsigned &a, const FixedUnsigned &n) {
+		FixedUnsigned result(1);
+		for (int bit = n.bitLength() - 1; bit >= 0; bit--) {
+			result = square(result);
+			if (n.testBit(bit)) {
+				result = multiply(result, a);
+			}
+		}
+		return result;
+	}
+
+	static FixedUnsigned powMod(const FixedUnsigned &a, const FixedUnsigned &e, const FixedUnsigned &m) {
+		if (m.isZero()) {
+			fprintf(stderr, "Modulus must be positive\n");
+			return FixedUnsigned();
+		}
+		const FixedUnsigned base = mod(a, m);
+		FixedUnsigned result = mod(FixedUnsigned(1), m);
+		for (int bit = e.bitLength() - 1; bit >= 0; bit--) {
+			result = mulMod(result, result, m);
+			if (e.testBit(bit)) {
+				result = mulMod(result, base, m);
+			}
+		}
+		return result;
+	}
+
+	static FixedUnsigned gcd(const FixedUnsigned &a, const FixedUnsigned &b) {
+		FixedUnsigned x(a), y(b);
+		while (!y.isZero()) {
+			const FixedUnsigned r = mod(x, y);
+			x = y;
+			y = r;
+		}
+		return x;
+	}
+
+	static FixedUnsigned doNot(const FixedUnsigned &a) { return FixedUnsigned(a.isZero() ? 1 : 0); }
+
+	// floor(sqrt(a)) by Newton's method from a power of two above it
+	static FixedUnsigned sqrt(const FixedUnsigned &a) {
+		if (a.isZero()) return a;
+		FixedUnsigned x;
+		x.setBit((a.bitLength() + 1) / 2);
+		for (;;) {
+			FixedUnsigned y = add(x, divide(a, x));
+			y = divide(y, FixedUnsigned(2));
+			if (compare(y, x) >= 0) return x;
+			x = y;
+		}
+	}
+
+	// floor(sqrt(a)), remainder = a - root^2
+	static FixedUnsigned sqrtRem(const FixedUnsigned &a, FixedUnsigned &remainder) {
+		const FixedUnsigned root = sqrt(a);
+		remainder = subtract(a, square(root));
+		return root;
+	}
+
+	// Squares end in one of 12 patterns of 6 bits, which rules most numbers out without a root
+	static bool isPerfectSquare(const FixedUnsigned &a) {
+		const limb_t low = a.mLimbs[0] % 64;
+		if (((0x0202021202030213ULL >> low) & 1) == 0) return false;
+		FixedUnsigned remainder;
+		sqrtRem(a, remainder);
+		return remainder.isZero();
+	}
+
+	// floor(a^(1/k)) by Newton's method from a power of two above it.  x^(k-1) is only worked
+	// out while it is at most a, above that a / x^(k-1) is 0.
+	static FixedUnsigned root(const FixedUnsigned &a, const limb_t k) {
+		if (k == 0) {
+			fprintf(stderr, "No root 0\n");
+			return FixedUnsigned();
+		}
+		if (a.isZero() || k == 1) return a;
+		const int bits = a.bitLength();
+		if (k >= (limb_t)bits) return FixedUnsigned(1);
+
+		FixedUnsigned x;
+		x.setBit((bits + (int)k - 1) / (int)k);
+		for (;;) {
+			FixedUnsigned power;
+			FixedUnsigned y = multiply(FixedUnsigned((unsigned long long)(k - 1)), x);
+			if (powAtMost(x, k - 1, a, power)) {
+				y.add(divide(a, power));
+			}
+			y = divide(y, FixedUnsigned((unsigned long long)k));
+			if (compare(y, x) >= 0) return x;
+			x = y;
+		}
+	}
+
+	// The low Bits bits of n!, 0 once n! has Bits factors of 2
+	static FixedUnsigned factorial(const limb_t n) {
+		FixedUnsigned result(1);
+		for (limb_t i = 2; i <= n && !result.isZero(); i++) {
+			result = multiply(result, FixedUnsigned((unsigned long long)i));
+		}
+		return result;
+	}
+
+	// Baillie-PSW like Unsigned::isPrime(): trial division by the primes to 41, a strong probable
+	// prime test to base 2, then a strong Lucas test.  No composite is known to pass both.
+	static FixedUnsigned isPrime(const FixedUnsigned &a) {
+		static const limb_t primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41 };
+		static const int nPrimes = sizeof(primes) / sizeof(primes[0]);
+
+		if (compare(a, FixedUnsigned(1)) <= 0) return FixedUnsigned();
+		for (int i = 0; i < nPrimes; i++) {
+			const FixedUnsigned prime((unsigned long long)primes[i]);
+			if (mod(a, prime).isZero()) return FixedUnsigned(a == prime ? 1 : 0);
+		}
+		if (a < FixedUnsigned(41 * 41)) return FixedUnsigned(1);
+
+		FixedUnsigned d = subtract(a, FixedUnsigned(1));
+		int s = 0;
+		while (d.isEven()) {
+			d = divide(d, FixedUnsigned(2));
+			s++;
+		}
+		if (!isStrongProbablePrime(a, d, s, FixedUnsigned(2))) return FixedUnsigned();
+
+		if (isPerfectSquare(a)) return FixedUnsigned();
+
+		return FixedUnsigned(isStrongLucasProbablePrime(a) ? 1 : 0);
+	}
+
+	// isPrime() and then strong probable prime tests to rounds random bases
+	static FixedUnsigned isProbablePrime(const FixedUnsigned &a, const int rounds) {
+		if (isPrime(a).isZero()) return FixedUnsigned();
+		if (a < FixedUnsigned(41 * 41)) return FixedUnsigned(1);
+
+		FixedUnsigned d = subtract(a, FixedUnsigned(1));
+		int s = 0;
+		while (d.isEven()) {
+			d = divide(d, FixedUnsigned(2));
+			s++;
+		}
+
+		// Bases from 2 to a - 2
+		const FixedUnsigned baseRange = subtract(a, FixedUnsigned(3));
+		const FixedUnsigned digits((unsigned long long)(a.bitLength() * 30103 / 100000 + 1));
+		for (int i = 0; i < rounds; i++) {
+			const FixedUnsigned base = add(mod(random(digits), baseRange), FixedUnsigned(2));
+			if (!isStrongProbablePrime(a, d, s, base)) return FixedUnsigned();
+		}
+		return FixedUnsigned(1);
+	}
+
+	// The smallest prime above n, which is 2 once that would be 2^Bits or more
+	static FixedUnsigned nextPrime(const FixedUnsigned &n) {
+		if (compare(n, FixedUnsigned(2)) < 0) return FixedUnsigned(2);
+		FixedUnsigned candidate = add(n, FixedUnsigned(n.isEven() ? 1 : 2));
+		while (compare(candidate, n) > 0 && isPrime(candidate).isZero()) {
+			candidate = add(candidate, FixedUnsigned(2));
+		}
+		return compare(candidate, n) > 0 ? candidate : FixedUnsigned(2);
+	}
+
+	// a = b^k for some b and k >= 2, or odd k >= 3 when oddOnly is set.  Like
+	// Unsigned::isPerfectPower() only prime k dividing the number of factors of 2 are tried.
+	static bool isPerfectPower(const FixedUnsigned &a, const bool oddOnly) {
+		if (compare(a, FixedUnsigned(1)) <= 0) return true;
+
+		int twos = 0;
+		while (!a.testBit(twos)) {
+			twos++;
+		}
+
+		const int bits = a.bitLength();
+		for (int k = 2; k < bits; k++) {
+			if ((twos > 0 && twos % k != 0) || (oddOnly && k == 2)) continue;
+			if (isPrime(FixedUnsigned((unsigned long long)k)).isZero()) continue;
+
+			if (k == 2) {
+				if (isPerfectSquare(a)) return true;
+				continue;
+			}
+			FixedUnsigned power;
+			if (powAtMost(root(a, (limb_t)k), (limb_t)k, a, power) && power == a) return true;
+		}
+		return false;
+	}
+
+	// The low Bits bits of n!! = n (n - 2) (n - 4) ...
+	static FixedUnsigned doubleFactorial(const limb_t n) {
+		FixedUnsigned result(1);
+		for (limb_t i = n; i > 1 && !result.isZero(); i -= 2) {
+			result = multiply(result, FixedUnsigned((unsigned long long)i));
+		}
+		return result;
+	}
+
+	// The low Bits bits of n! / k! = (k + 1) (k + 2) ... n, 1 for k >= n
+	static FixedUnsigned factorialRatio(const limb_t n, const limb_t k) {
+		FixedUnsigned result(1);
+		for (limb_t i = k + 1; k < n && i != n + 1 && !result.isZero(); i++) {
+			result = multiply(result, FixedUnsigned((unsigned long long)i));
+		}
+		return result;
+	}
+
+	// rand() digits through Unsigned::random()
+	static FixedUnsigned random(const FixedUnsigned &wantedDigits) {
+		return FixedUnsigned(Unsigned::random(Unsigned(wantedDigits)));
+	}
+
+	// Primes p with lo <= p < hi, 0 for a range of 2^32 numbers or more
+	static FixedUnsigned countPrimes(const FixedUnsigned &lo, const FixedUnsigned &hi) {
+		return FixedUnsigned(Unsigned::countPrimes(Unsigned(lo), Unsigned(hi)));
+	}
+
+	FixedUnsigned &operator+=(const FixedUnsigned &other) { add(other); return *this; }
+	FixedUnsigned &operator-=(const FixedUnsigned &other) { subtract(other); return *this; }
+	FixedUnsigned &operator*=(const FixedUnsigned &other) { *this = multiply(*this, other); return *this; }
+	FixedUnsigned &operator/=(const FixedUnsigned &other) { *this = divide(*this, other); return *this; }
+	FixedUnsigned &operator%=(const FixedUnsigned &other) { *this = mod(*this, other); return *this; }
+	FixedUnsigned &operator^=(const FixedUnsigned &other) { *this = pow(*this, other); return *this; }
+	FixedUnsigned operator++(int) { add(FixedUnsigned(1)); return *this; }
+	FixedUnsigned operator--(int) { subtract(FixedUnsigned(1)); return *this; }
+};
+
+template <int Bits>
+inline bool operator<(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) < 0; }
+template <int Bits>
+inline bool operator>(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) > 0; }
+template <int Bits>
+inline bool operator==(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) == 0; }
+template <int Bits>
+inline bool operator!=(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) != 0; }
+template <int Bits>
+inline bool operator<=(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) <= 0; }
+template <int Bits>
+inline bool operator>=(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::compare(a, b) >= 0; }
+template <int Bits>
+inline FixedUnsigned<Bits> operator+(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::add(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator-(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::subtract(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator*(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::multiply(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator/(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::divide(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator%(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::mod(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator^(const FixedUnsigned<Bits> &a, const FixedUnsigned<Bits> &b) { return FixedUnsigned<Bits>::pow(a, b); }
+template <int Bits>
+inline FixedUnsigned<Bits> operator!(const FixedUnsigned<Bits> &a) { return FixedUnsigned<Bits>::doNot(a); }
+
+template <int Bits>
+class FixedArbNum {
+	typedef Unsigned::limb_t limb_t;
+
+	bool mError;
+	int mSign;	// -1 or 1
+	FixedUnsigned<Bits> mUnsigned;
+
+	bool isNegative() const { return mSign < 0 && !isZero(); }
+
+	static FixedArbNum error() {
+		FixedArbNum result;
+		result.mkError();
+		return result;
+	}
+
+	// Factorial arguments must fit in a limb like ArbNum's, anything below zero counting as zero
+	static bool factorialArgument(const FixedArbNum &a, limb_t &n) {
+		if (a > FixedArbNum(0xFFFFFFFFLL)) {
+			fprintf(stderr, "Too big for a factorial: %s\n", a.toString().c_str());
+			return false;
+		}
+		n = a.isNegative() ? 0 : (limb_t)a.mUnsigned.toULongLong();
+		return true;
+	}
+
+	// The sign of a product or quotient
+	static int signOf(const FixedArbNum &a, const FixedArbNum &b) { return a.isNegative() != b.isNegative() ? -1 : 1; }
+
+	void addSigned(const FixedArbNum &other, const int otherSign) {
+		if ((mSign >= 0) == (otherSign >= 0)) {
+			mUnsigned.add(other.mUnsigned);
+			return;
+		}
+
+		const int order = FixedUnsigned<Bits>::compare(mUnsigned, other.mUnsigned);
+		if (order < 0) {
+			mUnsigned = FixedUnsigned<Bits>::subtract(other.mUnsigned, mUnsigned);
+			mSign = otherSign >= 0 ? 1 : -1;
+		}
+		else {
+			mUnsigned.subtract(other.mUnsigned);
+			if (order == 0) mSign = 1;
+		}
+	}
+
+public:
+	constexpr FixedArbNum() : mError(false), mSign(1), mUnsigned() { }
+	constexpr FixedArbNum(const long long value)
+		: mError(false), mSign(value < 0 ? -1 : 1),
+		  mUnsigned(value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value) { }
+	constexpr FixedArbNum(const int value) : FixedArbNum((long long)value) { }
+	FixedArbNum(const FixedUnsigned<Bits> &a) : mError(false), mSign(1), mUnsigned(a) { }
+	FixedArbNum(const char *s) : FixedArbNum(ArbNum(s)) { }
+
+	// The sign of a and the low Bits bits of its size
+	explicit FixedArbNum(const ArbNum &a) : mError(a.isError()), mSign(a.isNegative() ? -1 : 1), mUnsigned(a.mUnsigned) { }
+
+	explicit operator ArbNum() const {
+		ArbNum result = Unsigned(mUnsigned);
+		if (mError) {
+			result.mkError();
+		}
+		else if (isNegative()) {
+			result.mkNegative();
+		}
+		return result;
+	}
+
+	void mkError() { *this = FixedArbNum(); mError = true; }
+	bool isError() const { return mError; }
+	bool isZero() const { return mUnsigned.isZero(); }
+
+	std::string toString() const { return ArbNum(*this).toString(); }
+	// Negated as unsigned, so INT_MIN and the like don't overflow
+	int toInt() const {
+		const unsigned int size = (unsigned int)mUnsigned.toInt();
+		return (int)(isNegative() ? 0U - size : size);
+	}
+	long toLong() const {
+		const unsigned long size = (unsigned long)mUnsigned.toULongLong();
+		return (long)(isNegative() ? 0UL - size : size);
+	}
+	long long toLongLong() const {
+		const unsigned long long size = mUnsigned.toULongLong();
+		return (long long)(isNegative() ? 0ULL - size : size);
+	}
+	size_t limbs() const { return mUnsigned.limbs(); }
+
+	static int compare(const FixedArbNum &a, const FixedArbNum &b) {
+		const int aSign = a.isNegative() ? -1 : 1;
+		const int bSign = b.isNegative() ? -1 : 1;
+		if (aSign != bSign) return aSign < bSign ? -1 : 1;
+		return aSign * FixedUnsigned<Bits>::compare(a.mUnsigned, b.mUnsigned);
+	}
+
+	void add(const FixedArbNum &other) { addSigned(other, other.mSign); }
+	void subtract(const FixedArbNum &other) { addSigned(other, -other.mSign); }
+
+	static FixedArbNum abs(const FixedArbNum &a) { return FixedArbNum(a.mUnsigned); }
+	static FixedArbNum sign(const FixedArbNum &a) { return FixedArbNum(a.mSign); }
+	static FixedArbNum min(const FixedArbNum &a, const FixedArbNum &b) { return compare(a, b) < 0 ? a : b; }
+	static FixedArbNum max(const FixedArbNum &a, const FixedArbNum &b) { return compare(a, b) > 0 ? a : b; }
+	static FixedArbNum doNot(const FixedArbNum &a) { return FixedArbNum(a.isZero() ? 1 : 0); }
+
+	static FixedArbNum add(const FixedArbNum &a, const FixedArbNum &b) {
+		FixedArbNum result(a);
+		result.add(b);
+		return result;
+	}
+
+	static FixedArbNum subtract(const FixedArbNum &a, const FixedArbNum &b) {
+		FixedArbNum result(a);
+		result.subtract(b);
+		return result;
+	}
+
+	static FixedArbNum multiply(const FixedArbNum &a, const FixedArbNum &b) {
+		FixedArbNum result(FixedUnsigned<Bits>::multiply(a.mUnsigned, b.mUnsigned));
+		result.mSign = signOf(a, b);
+		return result;
+	}
+
+	// Quotients round toward zero and a remainder has the sign of the dividend, like ArbNum
+	static FixedArbNum divideWithRem(const FixedArbNum &a, const FixedArbNum &b, FixedArbNum &remainder) {
+		if (b.isZero()) {
+			fprintf(stderr, "Division by zero\n");
+			remainder = FixedArbNum();
+			return error();
+		}
+		FixedUnsigned<Bits> rem;
+		FixedArbNum quotient(FixedUnsigned<Bits>::divideWithRem(a.mUnsigned, b.mUnsigned, rem));
+		quotient.mSign = signOf(a, b);
+		remainder = FixedArbNum(rem);
+		remainder.mSign = a.isNegative() ? -1 : 1;
+		return quotient;
+	}
+
+	static FixedArbNum divide(const FixedArbNum &a, const FixedArbNum &b) {
+		FixedArbNum remainder;
+		return divideWithRem(a, b, remainder);
+	}
+
+	static FixedArbNum mod(const FixedArbNum &a, const FixedArbNum &b) {
+		FixedArbNum remainder;
+		divideWithRem(a, b, remainder);
+		return remainder;
+	}
+
+	// a^|n| like ArbNum::pow()
+	static FixedArbNum pow(const FixedArbNum &a, const FixedArbNum &n) {
+		FixedArbNum result(FixedUnsigned<Bits>::pow(a.mUnsigned, n.mUnsigned));
+		if (a.isNegative() && n.mUnsigned.isOdd()) {
+			result.mSign = -1;
+		}
+		return result;
+	}
+
+	static FixedArbNum gcd(const FixedArbNum &a, const FixedArbNum &b) {
+		return FixedArbNum(FixedUnsigned<Bits>::gcd(a.mUnsigned, b.mUnsigned));
+	}
+
+	// Returns gcd(a, b) = a * x + b * y.  Euclid's algorithm keeping both cofactors, which stay
+	// no bigger than |a| and |b| so they always fit.
+	static FixedArbNum gcdExtended(const FixedArbNum &a, const FixedArbNum &b, FixedArbNum &x, FixedArbNum &y) {
+		FixedArbNum oldR(a.mUnsigned), r(b.mUnsigned);
+		FixedArbNum oldS(1), s(0), oldT(0), t(1);
+		while (!r.isZero()) {
+			const FixedArbNum q = divide(oldR, r);
+			const FixedArbNum nextR = subtract(oldR, multiply(q, r));
+			const FixedArbNum nextS = subtract(oldS, multiply(q, s));
+			const FixedArbNum nextT = subtract(oldT, multiply(q, t));
+			oldR = r;
+			r = nextR;
+			oldS = s;
+			s = nextS;
+			oldT = t;
+			t = nextT;
+		}
+		x = a.isNegative() ? subtract(FixedArbNum(), oldS) : oldS;
+		y = b.isNegative() ? subtract(FixedArbNum(), oldT) : oldT;
+		return oldR;
+	}
+
+	// x with a * x = 1 (mod m), 0 <= x < m
+	static FixedArbNum modInverse(const FixedArbNum &a, const FixedArbNum &m) {
+		if (m.isNegative() || m.isZero()) {
+			fprintf(stderr, "Modulus must be positive\n");
+			return error();
+		}
+		FixedArbNum x, y;
+		if (gcdExtended(a, m, x, y) != FixedArbNum(1)) {
+			fprintf(stderr, "No inverse: %s and %s have a common factor\n", a.toString().c_str(), m.toString().c_str());
+			return error();
+		}
+		FixedArbNum result = mod(x, m);
+		if (result.isNegative()) {
+			result.add(m);
+		}
+		return result;
+	}
+
+	// The low Bits bits of n!, with n below zero counting as zero like ArbNum::factorial()
+	static FixedArbNum factorial(const FixedArbNum &n) {
+		limb_t limbN;
+		if (!factorialArgument(n, limbN)) return error();
+		return FixedArbNum(FixedUnsigned<Bits>::factorial(limbN));
+	}
+
+	static FixedArbNum doubleFactorial(const FixedArbNum &n) {
+		limb_t limbN;
+		if (!factorialArgument(n, limbN)) return error();
+		return FixedArbNum(FixedUnsigned<Bits>::doubleFactorial(limbN));
+	}
+
+	// The low Bits bits of n! / k!, 0 when k > n like ArbNum::partialFactorial()
+	static FixedArbNum partialFactorial(const FixedArbNum &n, const FixedArbNum &k) {
+		limb_t limbN, limbK;
+		if (!factorialArgument(n, limbN) || !factorialArgument(k, limbK)) return error();
+		if (limbK > limbN) return FixedArbNum();
+		return FixedArbNum(FixedUnsigned<Bits>::factorialRatio(limbN, limbK));
+	}
+
+	static FixedArbNum isPrime(const FixedArbNum &a) {
+		if (a.isNegative()) return FixedArbNum();
+		return FixedArbNum(FixedUnsigned<Bits>::isPrime(a.mUnsigned));
+	}
+
+	static FixedArbNum isProbablePrime(const FixedArbNum &a, const FixedArbNum &rounds) {
+		if (a.isNegative()) return FixedArbNum();
+		return FixedArbNum(FixedUnsigned<Bits>::isProbablePrime(a.mUnsigned, rounds.isNegative() ? 0 : rounds.toInt()));
+	}
+
+	static FixedArbNum nextPrime(const FixedArbNum &a) {
+		if (a.isNegative()) return FixedArbNum(2);
+		return FixedArbNum(FixedUnsigned<Bits>::nextPrime(a.mUnsigned));
+	}
+
+	// Primes p with lo <= p < hi
+	static FixedArbNum countPrimes(const FixedArbNum &lo, const FixedArbNum &hi) {
+		const FixedArbNum from = lo.isNegative() ? FixedArbNum() : lo;
+		if (hi <= from) return FixedArbNum();
+
+		const FixedArbNum range = subtract(hi, from);
+		if (range > FixedArbNum(0xFFFFFFFFLL)) {
+			fprintf(stderr, "Range too big: %s numbers\n", range.toString().c_str());
+			return error();
+		}
+		return FixedArbNum(FixedUnsigned<Bits>::countPrimes(from.mUnsigned, hi.mUnsigned));
+	}
+
+	static FixedArbNum random(const FixedArbNum &n) { return FixedArbNum(FixedUnsigned<Bits>::random(n.mUnsigned)); }
+
+	// a = b^k for some b and k >= 2, including -8 = (-2)^3
+	static FixedArbNum isPerfectPower(const FixedArbNum &a) {
+		// Only an odd power can be negative
+		return FixedArbNum(FixedUnsigned<Bits>::isPerfectPower(a.mUnsigned, a.isNegative()) ? 1 : 0);
+	}
+
+	// Needs a positive modulus and an exponent of zero or more.  The answer is in [0, m).
+	static FixedArbNum powMod(const FixedArbNum &a, const FixedArbNum &e, const FixedArbNum &m) {
+		if (m.isNegative() || m.isZero()) {
+			fprintf(stderr, "Modulus must be positive\n");
+			return error();
+		}
+		if (e.isNegative()) {
+			fprintf(stderr, "Exponent must not be negative\n");
+			return error();
+		}
+		FixedArbNum result(FixedUnsigned<Bits>::powMod(a.mUnsigned, e.mUnsigned, m.mUnsigned));
+		if (a.isNegative() && e.mUnsigned.isOdd() && !result.isZero()) {
+			result = FixedArbNum(FixedUnsigned<Bits>::subtract(m.mUnsigned, result.mUnsigned));
+		}
+		return result;
+	}
+
+	static FixedArbNum sqrt(const FixedArbNum &a) {
+		if (a.isNegative()) return error();
+		return FixedArbNum(FixedUnsigned<Bits>::sqrt(a.mUnsigned));
+	}
+
+	// floor(sqrt(a)) with remainder = a - root^2
+	static FixedArbNum sqrtRem(const FixedArbNum &a, FixedArbNum &remainder) {
+		if (a.isNegative()) {
+			remainder = error();
+			return error();
+		}
+		FixedUnsigned<Bits> rem;
+		const FixedArbNum root(FixedUnsigned<Bits>::sqrtRem(a.mUnsigned, rem));
+		remainder = FixedArbNum(rem);
+		return root;
+	}
+
+	static FixedArbNum isPerfectSquare(const FixedArbNum &a) {
+		if (a.isNegative()) return FixedArbNum();
+		return FixedArbNum(FixedUnsigned<Bits>::isPerfectSquare(a.mUnsigned) ? 1 : 0);
+	}
+
+	// The k-th root rounded toward zero.  Negative numbers have odd roots.
+	static FixedArbNum root(const FixedArbNum &a, const FixedArbNum &k) {
+		if (k.isNegative() || k.isZero() || (a.isNegative() && k.mUnsigned.isEven())) {
+			fprintf(stderr, "No root %s of %s\n", k.toString().c_str(), a.toString().c_str());
+			return error();
+		}
+		const limb_t limbK = k.mUnsigned > FixedUnsigned<Bits>(0xFFFFFFFFULL) ? 0xFFFFFFFF : (limb_t)k.mUnsigned.toULongLong();
+		FixedArbNum result(FixedUnsigned<Bits>::root(a.mUnsigned, limbK));
+		result.mSign = a.isNegative() ? -1 : 1;
+		return result;
+	}
+
+	FixedArbNum &operator+=(const FixedArbNum &other) { add(other); return *this; }
+	FixedArbNum &operator-=(const FixedArbNum &other) { subtract(other); return *this; }
+	FixedArbNum &operator*=(const FixedArbNum &other) { *this = multiply(*this, other); return *this; }
+	FixedArbNum &operator/=(const FixedArbNum &other) { *this = divide(*this, other); return *this; }
+	FixedArbNum &operator%=(const FixedArbNum &other) { *this = mod(*this, other); return *this; }
+	FixedArbNum &operator^=(const FixedArbNum &other) { *this = pow(*this, other); return *this; }
+	FixedArbNum operator++(int) { add(FixedArbNum(1)); return *this; }
+	FixedArbNum operator--(int) { subtract(FixedArbNum(1)); return *this; }
+};
+
+template <int Bits>
+inline bool operator<(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) < 0; }
+template <int Bits>
+inline bool operator>(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) > 0; }
+template <int Bits>
+inline bool operator==(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) == 0; }
+template <int Bits>
+inline bool operator!=(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) != 0; }
+template <int Bits>
+inline bool operator<=(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) <= 0; }
+template <int Bits>
+inline bool operator>=(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::compare(a, b) >= 0; }
+template <int Bits>
+inline FixedArbNum<Bits> operator+(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::add(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator-(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::subtract(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator*(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::multiply(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator/(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::divide(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator%(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::mod(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator^(const FixedArbNum<Bits> &a, const FixedArbNum<Bits> &b) { return FixedArbNum<Bits>::pow(a, b); }
+template <int Bits>
+inline FixedArbNum<Bits> operator!(const FixedArbNum<Bits> &a) { return FixedArbNum<Bits>::doNot(a); }
+
+#endif
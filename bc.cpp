@@ -15,17 +15,41 @@
 
 static void usage() {
   fprintf(stderr,
-          "Usage: bc\n"
+          "Usage: bc [-j threads] [-k kernels]\n"
           "\n"
           "bc - An arbitrary precision calculator language\n"
           "\n"
+          "-j threads  Use up to this many threads for big multiplications\n"
+          "-k kernels  Use these limb kernels instead of the best for this CPU:");
+  const std::vector<const char*> kernels = Unsigned::kernelChoices();
+  for (size_t i = 0; i < kernels.size(); i++) {
+    fprintf(stderr, " %s", kernels[i]);
+  }
+  fprintf(stderr,
+          "\n"
+          "\n"
           "Enter 'help' once in the program for help\n"
           "\n"
           "Copyright (c) 2020 Dave McKellar\n");
   exit(1);
 }
 
-int main(const int argc, char* argv[]) {
+int main(int argc, char* argv[]) {
+  // -j and -k in either order
+  while (argc > 2 && argv[1][0] == '-') {
+    if (strcmp(argv[1], "-j") == 0) {
+      const int threads = atoi(argv[2]);
+      if (threads < 1) usage();
+      Unsigned::setThreads(threads);
+    } else if (strcmp(argv[1], "-k") == 0) {
+      if (!Unsigned::setKernels(argv[2])) usage();
+    } else {
+      break;
+    }
+    argc -= 2;
+    argv += 2;
+  }
+
   if (argc > 1) {
     if (strcmp(argv[1], "-?") == 0) usage();
 
@@ -7,6 +7,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <vector>
+
 //------------------------------------------------------------------------------
 // Functions
 
@@ -18,19 +20,31 @@ typedef struct {
 
 // Alphabetical order
 static const Function gFuncs[] = {{"abs", 1, (void*)ArbNum::abs},
+                                  {"doublefactorial", 1, (void*)ArbNum::doubleFactorial},
                                   {"factorial", 1, (void*)ArbNum::factorial},
+                                  {"factorial", 2, (void*)ArbNum::partialFactorial},
                                   {"gcd", 2, (void*)ArbNum::gcd},
+                                  {"ispower", 1, (void*)ArbNum::isPerfectPower},
                                   {"isprime", 1, (void*)ArbNum::isPrime},
+                                  {"isprime", 2, (void*)ArbNum::isProbablePrime},
+                                  {"issquare", 1, (void*)ArbNum::isPerfectSquare},
                                   {"max", 2, (void*)ArbNum::max},
                                   {"min", 2, (void*)ArbNum::min},
+                                  {"modinv", 2, (void*)ArbNum::modInverse},
+                                  {"nextprime", 1, (void*)ArbNum::nextPrime},
+                                  {"powmod", 3, (void*)ArbNum::powMod},
+                                  {"primecount", 2, (void*)ArbNum::countPrimes},
                                   {"random", 1, (void*)ArbNum::random},
+                                  {"root", 2, (void*)ArbNum::root},
                                   {"sign", 1, (void*)ArbNum::sign},
                                   {"sqrt", 1, (void*)ArbNum::sqrt},
                                   {NULL, 0, NULL}};
 
-static const Function* findFunc(const char* name) {
+// The entry for name taking params parameters, or any entry for name when params is 0
+static const Function* findFunc(const char* name, const int params = 0) {
   for (const Function* pEntry = gFuncs; pEntry->name; pEntry++) {
-    if (strcmp(pEntry->name, name) == 0) {
+    if (strcmp(pEntry->name, name) == 0 &&
+        (params == 0 || pEntry->params == params)) {
       return pEntry;
     }
   }
@@ -41,6 +55,9 @@ static const std::string getFuncs() {
   std::string result;
 
   for (const Function* pEntry = gFuncs; pEntry->name; pEntry++) {
+    if (pEntry != gFuncs && strcmp(pEntry->name, pEntry[-1].name) == 0) {
+      continue;
+    }
     if (!result.empty()) result += ", ";
     result += (std::string)pEntry->name + (std::string) "()";
   }
@@ -49,44 +66,52 @@ static const std::string getFuncs() {
 
 typedef ArbNum (*func1_t)(ArbNum&);
 typedef ArbNum (*func2_t)(ArbNum&, ArbNum&);
+typedef ArbNum (*func3_t)(ArbNum&, ArbNum&, ArbNum&);
 
 ArbNum Calc::functionCall(Token funcName, Tokenizer& tokenizer) {
   ArbNum result;
 
-  const Function* pEntry = findFunc(funcName.string.c_str());
-  if (pEntry == NULL) {
+  if (findFunc(funcName.string.c_str()) == NULL) {
     fprintf(stderr, "Unknown function '%s'\n", funcName.string.c_str());
     result.mkError();
     return result;
   }
 
+  std::vector<ArbNum> args;
+  for (;;) {
+    const ArbNum arg = expr(tokenizer);
+    if (!arg.isNormal()) return arg;
+    args.push_back(arg);
+
+    const Token next = tokenizer.getToken();
+    if (next.isCloseBracket()) break;
+    if (!next.isComma()) {
+      fprintf(stderr, "Expected comma or close bracket, got '%s'\n",
+              next.string.c_str());
+      result.mkError();
+      return result;
+    }
+  }
+
+  // Some functions take an optional parameter and have an entry for each
+  const Function* pEntry =
+      findFunc(funcName.string.c_str(), (int)args.size());
+  if (pEntry == NULL) {
+    fprintf(stderr, "Wrong number of parameters for '%s', got %d\n",
+            funcName.string.c_str(), (int)args.size());
+    result.mkError();
+    return result;
+  }
+
   if (pEntry->params == 1) {
-    ArbNum expr1 = expr(tokenizer);
-    if (!expr1.isNormal()) return expr1;
     const func1_t pFunc1 = (func1_t)pEntry->func;
-    result = (*pFunc1)(expr1);
+    result = (*pFunc1)(args[0]);
   } else if (pEntry->params == 2) {
-    ArbNum expr1 = expr(tokenizer);
-    if (!expr1.isNormal()) return expr1;
-    const Token comma = tokenizer.getToken();
-    ArbNum expr2 = expr(tokenizer);
-    if (!expr2.isNormal()) return expr2;
     const func2_t pFunc2 = (func2_t)pEntry->func;
-    result = (*pFunc2)(expr1, expr2);
+    result = (*pFunc2)(args[0], args[1]);
   } else {
-    fprintf(stderr,
-            "Can not handle functions with more than 2 parameters, got '%s'\n",
-            funcName.string.c_str());
-    result.mkError();
-    return result;
-  }
-
-  const Token closeBracket = tokenizer.getToken();
-  if (!closeBracket.isCloseBracket()) {
-    fprintf(stderr, "Expected close bracket, got '%s'\n",
-            closeBracket.string.c_str());
-    result.mkError();
-    return result;
+    const func3_t pFunc3 = (func3_t)pEntry->func;
+    result = (*pFunc3)(args[0], args[1], args[2]);
   }
 
   return result;
@@ -109,7 +134,14 @@ void Calc::help() {
   printf("Built-in functions: %s\n", getFuncs().c_str());
   printf("Examples:\n");
   printf("\tgcd(10 * 10, 6 + 7)\n");
+  printf("\tmodinv(3, 7)\n");
+  printf("\troot(10 ^ 30, 3) for the cube root\n");
+  printf("\tpowmod(3, 10 ^ 100, 1000000007) for 3 ^ 10 ^ 100 mod 1000000007\n");
+  printf("\tfactorial(100, 95) for 100! / 95!\n");
   printf("\t! isprime(27)\n");
+  printf("\tisprime(2 ^ 127 - 1, 20) for 20 extra Miller-Rabin rounds\n");
+  printf("\tnextprime(10 ^ 20)\n");
+  printf("\tprimecount(10 ^ 12, 10 ^ 12 + 1000000) for the primes from 10^12 up to but not including 10^12 + 1000000\n");
   printf("\n");
   printf("help <enter> for this\n");
   printf("tests <enter> to run checks\n");
@@ -229,11 +261,15 @@ ArbNum Calc::expr(Tokenizer& tokenizer) {
 }
 
 void Calc::run(const char* line) {
-  Tokenizer tokenizer(line);
+  {
+    const LimbAllocatorScope scope(mArena);
+    Tokenizer tokenizer(line);
 
-  const ArbNum num = expr(tokenizer);
+    const ArbNum num = expr(tokenizer);
 
-  if (num.isNormal()) {
-    printf("%s\n", num.toString().c_str());
+    if (num.isNormal()) {
+      printf("%s\n", num.toString().c_str());
+    }
   }
+  mArena.reset();
 }
@@ -9,6 +9,8 @@
 #include "bc_tokenizer.h"
 
 class Calc {
+  LimbArena mArena;  // The numbers of one line
+
   ArbNum functionCall(Token, Tokenizer&);
   void help();
   void license();
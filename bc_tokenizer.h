@@ -26,6 +26,7 @@ struct Token {
   std::string toString() const;
   bool isOpenBracket() const { return type == T_PUNCT && string == "("; }
   bool isCloseBracket() const { return type == T_PUNCT && string == ")"; }
+  bool isComma() const { return type == T_PUNCT && string == ","; }
   bool isBang() const { return type == T_PUNCT && string == "!"; }
 };
 